@@ -0,0 +1,188 @@
+#include "VXRCalibrationAnalysis.h"
+#include "VXRCalibrationInterpolation.h"
+#include "VXRStaticKdTree.h"
+#include "Async/ParallelFor.h"
+#include "VXRLog.h"
+
+DECLARE_CYCLE_STAT( TEXT( "VXR Calibration Analysis" ), STAT_VXRCalibrationAnalysis, STATGROUP_VXR );
+
+namespace
+{
+    const int32 ChunkSize = 1024;
+
+    struct FSampleEvaluation
+    {
+        // Negative when the sample has fewer than two neighbours.
+        float Error;
+        FVector NeighbourCenter;
+    };
+
+    struct FCellAccumulator
+    {
+        int32 SampleCount = 0;
+        int32 EvaluatedCount = 0;
+        double ErrorSum = 0.0;
+        float MaxError = 0.0f;
+        int32 WorstSample = INDEX_NONE;
+    };
+
+    FSampleEvaluation EvaluateSample( const FVXRStaticKdTree& InKdTree, const FVXRCameraData& InSample )
+    {
+        FSampleEvaluation evaluation;
+        evaluation.Error = -1.0f;
+        evaluation.NeighbourCenter = InSample.Position;
+
+        FVXRCameraData nearest[3];
+        auto found = InKdTree.FindNearest( InSample.Position, nearest, 3 );
+
+        // Leave the sample itself out; with duplicated positions only one copy is dropped.
+        FVXRCameraData* neighbours[2];
+        int32 neighbourCount = 0;
+        auto skipped = false;
+        for ( int32 i = 0; i < found && neighbourCount < 2; ++i ) {
+            auto& data = nearest[i];
+            if ( !skipped && data.Position == InSample.Position && data.OffsetYaw == InSample.OffsetYaw && data.OffsetPitch == InSample.OffsetPitch ) {
+                skipped = true;
+                continue;
+            }
+            neighbours[neighbourCount++] = &data;
+        }
+
+        if ( neighbourCount < 2 )
+            return evaluation;
+
+        // Queries outside the segment of the two neighbours are common here; the zero result the runtime
+        // gives them is part of the error, so the return value is not checked.
+        float yaw, pitch;
+        VXRCalibrationInterpolation::InterpolateRotatorComponent( InSample.Position, neighbours[0]->OffsetYaw, neighbours[1]->OffsetYaw,
+            neighbours[0]->Position, neighbours[1]->Position, yaw );
+        VXRCalibrationInterpolation::InterpolateRotatorComponent( InSample.Position, neighbours[0]->OffsetPitch, neighbours[1]->OffsetPitch,
+            neighbours[0]->Position, neighbours[1]->Position, pitch );
+
+        evaluation.Error = FMath::Sqrt( FMath::Square( yaw - InSample.OffsetYaw ) + FMath::Square( pitch - InSample.OffsetPitch ) );
+        evaluation.NeighbourCenter = 0.5f * (neighbours[0]->Position + neighbours[1]->Position);
+        return evaluation;
+    }
+
+    FIntVector GetCellKey( const FVector& InPosition, float InCellSize )
+    {
+        return FIntVector( FMath::FloorToInt( InPosition.X / InCellSize ), FMath::FloorToInt( InPosition.Y / InCellSize ),
+            FMath::FloorToInt( InPosition.Z / InCellSize ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void VXRCalibrationAnalysis::Analyze( const TArray<FVXRCameraData>& InCameraDatas, float InCellSize, int32 InSuggestionCount,
+    FVXRCalibrationAnalysisResult& OutResult )
+{
+    SCOPE_CYCLE_COUNTER( STAT_VXRCalibrationAnalysis );
+
+    auto start = FPlatformTime::Seconds();
+    auto cellSize = FMath::Max( InCellSize, KINDA_SMALL_NUMBER );
+
+    OutResult = FVXRCalibrationAnalysisResult();
+    OutResult.SampleCount = InCameraDatas.Num();
+    OutResult.CellSize = cellSize;
+    if ( InCameraDatas.Num() == 0 )
+        return;
+
+    FVXRStaticKdTree kdTree;
+    kdTree.Build( InCameraDatas );
+
+    TArray<FSampleEvaluation> evaluations;
+    evaluations.SetNumUninitialized( InCameraDatas.Num() );
+    auto chunkCount = FMath::DivideAndRoundUp( InCameraDatas.Num(), ChunkSize );
+    ParallelFor( chunkCount, [&kdTree, &evaluations, &InCameraDatas]( int32 InChunk ){
+            auto end = FMath::Min( (InChunk + 1) * ChunkSize, InCameraDatas.Num() );
+            for ( int32 i = InChunk * ChunkSize; i < end; ++i )
+                evaluations[i] = EvaluateSample( kdTree, InCameraDatas[i] );
+        }, chunkCount == 1 );
+
+    // Accumulation is cheap next to the queries, so it stays serial.
+    TMap<FIntVector, FCellAccumulator> cells;
+    FBox bounds( ForceInit );
+    double errorSum = 0.0;
+    for ( int32 i = 0; i < InCameraDatas.Num(); ++i ) {
+        auto& position = InCameraDatas[i].Position;
+        bounds += position;
+
+        auto& cell = cells.FindOrAdd( GetCellKey( position, cellSize ) );
+        ++cell.SampleCount;
+
+        auto error = evaluations[i].Error;
+        if ( error < 0.0f ) {
+            ++OutResult.SkippedCount;
+            continue;
+        }
+
+        ++cell.EvaluatedCount;
+        cell.ErrorSum += error;
+        if ( cell.WorstSample == INDEX_NONE || error > cell.MaxError ) {
+            cell.MaxError = error;
+            cell.WorstSample = i;
+        }
+        errorSum += error;
+        OutResult.MaxError = FMath::Max( OutResult.MaxError, error );
+    }
+
+    auto evaluated = OutResult.SampleCount - OutResult.SkippedCount;
+    OutResult.MeanError = evaluated > 0 ? (float)(errorSum / evaluated) : 0.0f;
+
+    OutResult.Cells.Reserve( cells.Num() );
+    for ( auto& cell : cells ) {
+        auto& outCell = OutResult.Cells.AddDefaulted_GetRef();
+        outCell.Key = cell.Key;
+        outCell.Center = (FVector( cell.Key ) + FVector( 0.5f )) * cellSize;
+        outCell.SampleCount = cell.Value.SampleCount;
+        outCell.MeanError = cell.Value.EvaluatedCount > 0 ? (float)(cell.Value.ErrorSum / cell.Value.EvaluatedCount) : 0.0f;
+        outCell.MaxError = cell.Value.MaxError;
+
+        if ( cell.Value.WorstSample != INDEX_NONE && outCell.MeanError > 0.0f ) {
+            auto& evaluation = evaluations[cell.Value.WorstSample];
+            auto& suggestion = OutResult.Suggestions.AddDefaulted_GetRef();
+            suggestion.Position = 0.5f * (InCameraDatas[cell.Value.WorstSample].Position + evaluation.NeighbourCenter);
+            suggestion.Score = outCell.MeanError;
+            suggestion.CellIndex = OutResult.Cells.Num() - 1;
+        }
+    }
+
+    // Empty neighbours of occupied cells inside the sample bounds are the coverage gaps of the heat map.
+    auto minKey = GetCellKey( bounds.Min, cellSize );
+    auto maxKey = GetCellKey( bounds.Max, cellSize );
+    TSet<FIntVector> emptyKeys;
+    for ( auto& cell : cells ) {
+        for ( int32 z = -1; z <= 1; ++z ) {
+            for ( int32 y = -1; y <= 1; ++y ) {
+                for ( int32 x = -1; x <= 1; ++x ) {
+                    auto key = cell.Key + FIntVector( x, y, z );
+                    if ( key.X < minKey.X || key.Y < minKey.Y || key.Z < minKey.Z || key.X > maxKey.X || key.Y > maxKey.Y || key.Z > maxKey.Z )
+                        continue;
+                    if ( !cells.Contains( key ) )
+                        emptyKeys.Add( key );
+                }
+            }
+        }
+    }
+
+    OutResult.EmptyCellCount = emptyKeys.Num();
+    for ( auto& key : emptyKeys ) {
+        auto& outCell = OutResult.Cells.AddDefaulted_GetRef();
+        outCell.Key = key;
+        outCell.Center = (FVector( key ) + FVector( 0.5f )) * cellSize;
+    }
+
+    // Mean rather than summed error, so cells that are already densely sampled do not rank first.
+    OutResult.Suggestions.Sort( [&OutResult]( const FVXRCalibrationSuggestion& InA, const FVXRCalibrationSuggestion& InB ){
+            if ( InA.Score != InB.Score )
+                return InA.Score > InB.Score;
+            return OutResult.Cells[InA.CellIndex].MaxError > OutResult.Cells[InB.CellIndex].MaxError;
+        } );
+    if ( OutResult.Suggestions.Num() > FMath::Max( InSuggestionCount, 0 ) )
+        OutResult.Suggestions.SetNum( FMath::Max( InSuggestionCount, 0 ) );
+
+    OutResult.ElapsedSeconds = (float)(FPlatformTime::Seconds() - start);
+    VXR_LOG( Log, TEXT( "#### Calibration analysis. Samples:[%d] Skipped:[%d] Mean error:[%.4f] Max error:[%.4f] Cells:[%d] Empty cells:[%d] Elapsed:[%.3f s] ####" ),
+        OutResult.SampleCount, OutResult.SkippedCount, OutResult.MeanError, OutResult.MaxError, OutResult.Cells.Num(),
+        OutResult.EmptyCellCount, OutResult.ElapsedSeconds );
+}
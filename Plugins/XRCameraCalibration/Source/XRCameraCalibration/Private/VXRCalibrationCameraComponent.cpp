@@ -0,0 +1,154 @@
+#include "VXRCalibrationCameraComponent.h"
+#include "VXROctreeController.h"
+#include "Camera/CameraComponent.h"
+#include "GameFramework/Actor.h"
+#include "VXRLog.h"
+
+DECLARE_CYCLE_STAT( TEXT( "VXR Camera Correction" ), STAT_VXRCameraCorrection, STATGROUP_VXR );
+
+//-----------------------------------------------------------------------------
+
+UVXRCalibrationCameraComponent::UVXRCalibrationCameraComponent( const FObjectInitializer& ObjectInitializer )
+    : Super( ObjectInitializer )
+{
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = true;
+
+    CorrectionTickGroup = TG_PrePhysics;
+    ApplyYaw = true;
+    ApplyPitch = true;
+    LastCorrectionTimeMs = 0.0f;
+
+    BaseRotation = FRotator::ZeroRotator;
+    LastWrittenRotation = FRotator::ZeroRotator;
+    AppliedOffset = FRotator::ZeroRotator;
+    HasWrittenRotation = false;
+}
+
+void UVXRCalibrationCameraComponent::BeginPlay()
+{
+    ResolveComponents();
+    SetTickGroup( CorrectionTickGroup );
+    if ( TrackingUpdateComponent != nullptr )
+        AddTickPrerequisiteComponent( TrackingUpdateComponent );
+
+    Super::BeginPlay();
+}
+
+void UVXRCalibrationCameraComponent::EndPlay( EEndPlayReason::Type InEndPlayReason )
+{
+    RestoreBaseRotation();
+
+    Super::EndPlay( InEndPlayReason );
+}
+
+void UVXRCalibrationCameraComponent::ResolveComponents()
+{
+    auto owner = GetOwner();
+    if ( TrackedComponent == nullptr )
+        TrackedComponent = Cast<USceneComponent>( ResolveComponentReference( TrackedComponentReference ) );
+    if ( CorrectedComponent == nullptr )
+        CorrectedComponent = Cast<USceneComponent>( ResolveComponentReference( CorrectedComponentReference ) );
+    if ( TrackingUpdateComponent == nullptr )
+        TrackingUpdateComponent = ResolveComponentReference( TrackingUpdateComponentReference );
+
+    if ( TrackedComponent == nullptr && owner != nullptr ) {
+        TrackedComponent = owner->FindComponentByClass<UCameraComponent>();
+        if ( TrackedComponent == nullptr )
+            TrackedComponent = owner->GetRootComponent();
+    }
+
+    if ( CorrectedComponent == nullptr )
+        CorrectedComponent = TrackedComponent;
+
+    VXR_CLOG( TrackedComponent == nullptr, Warning, TEXT( "#### No tracked component for calibration camera. Owner:[%s] ####" ),
+        *GetNameSafe( owner ) );
+}
+
+UActorComponent* UVXRCalibrationCameraComponent::ResolveComponentReference( const FComponentReference& InReference ) const
+{
+    // An empty reference would resolve to the root component, which would hide the defaults.
+    if ( InReference.ComponentProperty.IsNone() && InReference.OtherActor == nullptr )
+        return nullptr;
+
+    auto component = InReference.GetComponent( GetOwner() );
+    if ( component == nullptr && !InReference.ComponentProperty.IsNone() ) {
+        // Instance components have no property on the actor class; match them by name.
+        auto searchActor = InReference.OtherActor != nullptr ? InReference.OtherActor : GetOwner();
+        if ( searchActor != nullptr ) {
+            for ( auto actorComponent : searchActor->GetComponents() ) {
+                if ( actorComponent != nullptr && actorComponent->GetFName() == InReference.ComponentProperty ) {
+                    component = actorComponent;
+                    break;
+                }
+            }
+        }
+    }
+
+    VXR_CLOG( component == nullptr, Warning, TEXT( "#### Unresolved component reference. Owner:[%s] Component:[%s] ####" ),
+        *GetNameSafe( GetOwner() ), *InReference.ComponentProperty.ToString() );
+    return component;
+}
+
+void UVXRCalibrationCameraComponent::SetTrackedComponent( USceneComponent* InTrackedComponent )
+{
+    TrackedComponent = InTrackedComponent;
+}
+
+void UVXRCalibrationCameraComponent::SetCorrectedComponent( USceneComponent* InCorrectedComponent )
+{
+    RestoreBaseRotation();
+    CorrectedComponent = InCorrectedComponent;
+}
+
+void UVXRCalibrationCameraComponent::SetTrackingUpdateComponent( UActorComponent* InTrackingUpdateComponent )
+{
+    if ( TrackingUpdateComponent != nullptr )
+        RemoveTickPrerequisiteComponent( TrackingUpdateComponent );
+
+    TrackingUpdateComponent = InTrackingUpdateComponent;
+    if ( TrackingUpdateComponent != nullptr )
+        AddTickPrerequisiteComponent( TrackingUpdateComponent );
+}
+
+FRotator UVXRCalibrationCameraComponent::GetAppliedOffset() const
+{
+    return AppliedOffset;
+}
+
+void UVXRCalibrationCameraComponent::TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction )
+{
+    Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
+
+    if ( CalibrationController == nullptr || TrackedComponent == nullptr || CorrectedComponent == nullptr )
+        return;
+
+    SCOPE_CYCLE_COUNTER( STAT_VXRCameraCorrection );
+    auto startCycles = FPlatformTime::Cycles64();
+
+    // When the tracker did not write a new transform since our last correction, the current rotation
+    // still contains our previous offset, so keep correcting from the remembered base rotation.
+    auto currentRotation = CorrectedComponent->GetRelativeRotation();
+    if ( !HasWrittenRotation || !currentRotation.Equals( LastWrittenRotation ) )
+        BaseRotation = currentRotation;
+
+    auto offset = CalibrationController->GetCollectCameraRotation( TrackedComponent->GetComponentLocation(), QueryCache );
+    AppliedOffset = FRotator( ApplyPitch ? offset.Pitch : 0.0f, ApplyYaw ? offset.Yaw : 0.0f, 0.0f );
+
+    CorrectedComponent->SetRelativeRotation( BaseRotation + AppliedOffset );
+    LastWrittenRotation = CorrectedComponent->GetRelativeRotation();
+    HasWrittenRotation = true;
+
+    LastCorrectionTimeMs = (float)FPlatformTime::ToMilliseconds64( FPlatformTime::Cycles64() - startCycles );
+}
+
+void UVXRCalibrationCameraComponent::RestoreBaseRotation()
+{
+    if ( HasWrittenRotation && CorrectedComponent != nullptr ) {
+        if ( CorrectedComponent->GetRelativeRotation().Equals( LastWrittenRotation ) )
+            CorrectedComponent->SetRelativeRotation( BaseRotation );
+    }
+
+    HasWrittenRotation = false;
+    AppliedOffset = FRotator::ZeroRotator;
+}
@@ -0,0 +1,74 @@
+#include "VXRCalibrationDataAsset.h"
+#include "VXRStaticKdTree.h"
+#include "VXRLog.h"
+
+namespace
+{
+    // Bump when FVXRKdNode, FVXRCameraData or the kd-tree storage order change.
+    const int32 CalibrationLayoutVersion = 1;
+}
+
+//-----------------------------------------------------------------------------
+
+UVXRCalibrationDataAsset::UVXRCalibrationDataAsset( const FObjectInitializer& ObjectInitializer )
+    : Super( ObjectInitializer )
+{
+    SampleCount = 0;
+    NodeCount = 0;
+    // Differs from every real layout, so the saved value is always serialized.
+    LayoutVersion = 0;
+}
+
+void UVXRCalibrationDataAsset::Serialize( FArchive& Ar )
+{
+    Super::Serialize( Ar );
+
+    IndexBulkData.Serialize( Ar, this );
+}
+
+void UVXRCalibrationDataAsset::SetCameraDatas( const TArray<FVXRCameraData>& InCameraDatas )
+{
+    FVXRStaticKdTree kdTree;
+    kdTree.Build( InCameraDatas );
+
+    auto& storage = kdTree.GetStorage();
+    IndexBulkData.Lock( LOCK_READ_WRITE );
+    auto data = IndexBulkData.Realloc( storage.Num() );
+    FMemory::Memcpy( data, storage.GetData(), storage.Num() );
+    IndexBulkData.Unlock();
+    // Stored apart from the export so the payload streams in on first use.
+    IndexBulkData.SetBulkDataFlags( BULKDATA_Force_NOT_InlinePayload );
+
+    SampleCount = kdTree.Num();
+    NodeCount = kdTree.GetNodeCount();
+    LayoutVersion = CalibrationLayoutVersion;
+}
+
+bool UVXRCalibrationDataAsset::CreateKdTree( FVXRStaticKdTree& OutKdTree ) const
+{
+    if ( SampleCount == 0 )
+        return false;
+
+    if ( LayoutVersion != CalibrationLayoutVersion ) {
+        VXR_LOG( Warning, TEXT( "#### Calibration asset has an outdated layout, reimport it. Asset:[%s] Version:[%d] ####" ), 
+            *GetName(), LayoutVersion );
+        return false;
+    }
+
+    // GetCopy is not const. Discarding the internal copy hands over the loaded payload instead of keeping it
+    // resident next to the tree; it is read from disk again on the next call.
+    auto& bulkData = const_cast<FByteBulkData&>( IndexBulkData );
+    auto size = bulkData.GetBulkDataSize();
+    void* data = nullptr;
+    bulkData.GetCopy( &data, true );
+    auto result = data != nullptr && OutKdTree.InitFromStorage( data, size, NodeCount, SampleCount );
+    FMemory::Free( data );
+
+    VXR_CLOG( !result, Warning, TEXT( "#### Failed to load calibration asset. Asset:[%s] Size:[%lld bytes] ####" ), *GetName(), size );
+    return result;
+}
+
+int32 UVXRCalibrationDataAsset::GetSampleCount() const
+{
+    return SampleCount;
+}
@@ -0,0 +1,52 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+
+// Rotation interpolation between two calibration samples, shared by the runtime lookup and the calibration analysis.
+// vxr_shm_interpolate in VXRCalibrationShmReader.h mirrors it for out-of-process readers.
+namespace VXRCalibrationInterpolation
+{
+    // One offset component lerped by the projection of InCameraPosition onto the segment of the two samples.
+    // Returns false, with OutValue 0, when the projection lies beyond the segment.
+    inline bool InterpolateRotatorComponent( const FVector& InCameraPosition, float InRotComp0, float InRotComp1, 
+        const FVector& InElementPos0, const FVector& InElementPos1, float& OutValue )
+    {
+        FVector minPos, maxPos;
+        float minValue, maxValue;
+
+        if ( InRotComp0 < InRotComp1 ) {
+            minValue = InRotComp0;
+            maxValue = InRotComp1;
+
+            minPos = InElementPos0;
+            maxPos = InElementPos1;
+        }
+        else {
+            minValue = InRotComp1;
+            maxValue = InRotComp0;
+
+            minPos = InElementPos1;
+            maxPos = InElementPos0;
+        }
+
+        auto direction = maxPos - minPos;
+        auto dirSize = direction.Size();
+        // Coincident samples: same result as vxr_shm_interpolate instead of 0/0.
+        if ( dirSize <= SMALL_NUMBER ) {
+            OutValue = minValue;
+            return true;
+        }
+
+        auto dirCamera = InCameraPosition - minPos;
+        auto projection = dirCamera.ProjectOnToNormal( direction / dirSize );
+        auto projSize = projection.Size();
+
+        if ( dirSize < projSize ) {
+            OutValue = 0.0f;
+            return false;
+        }
+
+        OutValue = FMath::Lerp( minValue, maxValue, projSize / dirSize );
+        return true;
+    }
+}
@@ -0,0 +1,96 @@
+#include "VXRCalibrationPublisher.h"
+#include "VXRCalibrationShm.h"
+#include "VXRStaticKdTree.h"
+#include "VXRLog.h"
+
+static_assert( sizeof( VXRShmNode ) == sizeof( FVXRKdNode ), "VXRShmNode must match FVXRKdNode." );
+static_assert( sizeof( VXRShmSample ) == sizeof( FVXRCameraData ), "VXRShmSample must match FVXRCameraData." );
+static_assert( STRUCT_OFFSET( FVXRCameraData, OffsetYaw ) == STRUCT_OFFSET( VXRShmSample, offset_yaw ), "VXRShmSample must match FVXRCameraData." );
+
+FVXRCalibrationPublisher::~FVXRCalibrationPublisher()
+{
+    Close();
+}
+
+bool FVXRCalibrationPublisher::Open( const FString& InName, int32 InSampleCapacity )
+{
+    Close();
+
+    if ( InName.IsEmpty() || InSampleCapacity <= 0 )
+        return false;
+
+    // Same leaf rule as FVXRStaticKdTree::Build, so any tree up to the capacity fits.
+    int32 leafLevel = 0;
+    while ( (InSampleCapacity >> leafLevel) > FVXRStaticKdTree::LeafSize )
+        ++leafLevel;
+
+    auto nodeCapacity = (1 << (leafLevel + 1)) - 1;
+    auto size = vxr_shm_segment_size( (uint32)InSampleCapacity, (uint32)nodeCapacity );
+    Region = FPlatformMemory::MapNamedSharedMemoryRegion( InName, true,
+        FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, (SIZE_T)size );
+    if ( Region == nullptr ) {
+        VXR_LOG( Warning, TEXT( "#### Failed to map shared memory. Name:[%s] Size:[%llu bytes] ####" ), *InName, size );
+        return false;
+    }
+
+    SampleCapacity = InSampleCapacity;
+    NodeCapacity = nodeCapacity;
+
+    auto header = static_cast<VXRShmHeader*>( Region->GetAddress() );
+    FMemory::Memzero( header, sizeof( VXRShmHeader ) );
+    header->version = VXR_SHM_VERSION;
+    header->sample_capacity = (uint32)SampleCapacity;
+    header->node_capacity = (uint32)NodeCapacity;
+    header->nodes_offset = sizeof( VXRShmHeader );
+    header->samples_offset = sizeof( VXRShmHeader ) + NodeCapacity * sizeof( VXRShmNode );
+    FPlatformMisc::MemoryBarrier();
+    // Magic last, readers reject the segment until the header is complete.
+    header->magic = VXR_SHM_MAGIC;
+
+    VXR_LOG( Log, TEXT( "#### Open shared memory. Name:[%s] Samples:[%d] Size:[%llu bytes] ####" ), *InName, SampleCapacity, size );
+    return true;
+}
+
+void FVXRCalibrationPublisher::Close()
+{
+    if ( Region != nullptr ) {
+        FPlatformMemory::UnmapNamedSharedMemoryRegion( Region );
+        Region = nullptr;
+    }
+
+    SampleCapacity = 0;
+    NodeCapacity = 0;
+}
+
+bool FVXRCalibrationPublisher::IsOpen() const
+{
+    return Region != nullptr;
+}
+
+int32 FVXRCalibrationPublisher::GetSampleCapacity() const
+{
+    return SampleCapacity;
+}
+
+bool FVXRCalibrationPublisher::Publish( const FVXRStaticKdTree& InKdTree, bool InTruncated )
+{
+    if ( Region == nullptr || InKdTree.Num() > SampleCapacity || InKdTree.GetNodeCount() > NodeCapacity )
+        return false;
+
+    auto base = static_cast<uint8*>( Region->GetAddress() );
+    auto header = reinterpret_cast<VXRShmHeader*>( base );
+    auto sequence = reinterpret_cast<volatile int32*>( &header->sequence );
+
+    // Odd sequence while writing; readers retry until they see the same even value on both ends.
+    FPlatformAtomics::InterlockedIncrement( sequence );
+
+    FMemory::Memcpy( base + header->nodes_offset, InKdTree.GetNodes(), InKdTree.GetNodeCount() * sizeof( VXRShmNode ) );
+    FMemory::Memcpy( base + header->samples_offset, InKdTree.GetSamples(), InKdTree.Num() * sizeof( VXRShmSample ) );
+    header->node_count = (uint32)InKdTree.GetNodeCount();
+    header->sample_count = (uint32)InKdTree.Num();
+    header->flags = InTruncated ? VXR_SHM_FLAG_TRUNCATED : 0u;
+    ++header->generation;
+
+    FPlatformAtomics::InterlockedIncrement( sequence );
+    return true;
+}
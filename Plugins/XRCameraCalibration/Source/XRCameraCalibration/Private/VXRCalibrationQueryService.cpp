@@ -0,0 +1,134 @@
+#include "VXRCalibrationQueryService.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "VXRLog.h"
+
+DECLARE_CYCLE_STAT( TEXT( "VXR Resolve Correction Batch" ), STAT_VXRResolveCorrectionBatch, STATGROUP_VXR );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "VXR Correction Requests" ), STAT_VXRCorrectionRequests, STATGROUP_VXR );
+
+int32 UVXRCalibrationQueryService::ParallelThreshold = 8;
+
+static FAutoConsoleVariableRef CVarVXRQueryServiceParallelThreshold(
+    TEXT( "vxr.QueryService.ParallelThreshold" ),
+    UVXRCalibrationQueryService::ParallelThreshold,
+    TEXT( "Minimum number of correction requests in a frame before the batch is resolved on worker threads." ) );
+
+//-----------------------------------------------------------------------------
+
+FVXRCorrectionHandle UVXRCalibrationQueryService::RegisterRequester( AVXROctreeController* InController )
+{
+    FVXRCorrectionHandle handle;
+    if ( InController == nullptr )
+        return handle;
+
+    FRequester requester;
+    requester.Controller = InController;
+    requester.Position = FVector::ZeroVector;
+    requester.Result = FRotator::ZeroRotator;
+    requester.Serial = NextSerial++;
+    requester.Pending = false;
+
+    handle.Index = Requesters.Add( requester );
+    handle.Serial = requester.Serial;
+    return handle;
+}
+
+void UVXRCalibrationQueryService::UnregisterRequester( FVXRCorrectionHandle& InHandle )
+{
+    if ( FindRequester( InHandle ) != nullptr ) {
+        PendingIndices.Remove( InHandle.Index );
+        Requesters.RemoveAt( InHandle.Index );
+    }
+
+    InHandle = FVXRCorrectionHandle();
+}
+
+UVXRCalibrationQueryService::FRequester* UVXRCalibrationQueryService::FindRequester( const FVXRCorrectionHandle& InHandle )
+{
+    if ( InHandle.IsValid() && Requesters.IsValidIndex( InHandle.Index ) ) {
+        auto& requester = Requesters[InHandle.Index];
+        if ( requester.Serial == InHandle.Serial )
+            return &requester;
+    }
+
+    return nullptr;
+}
+
+bool UVXRCalibrationQueryService::SubmitRequest( const FVXRCorrectionHandle& InHandle, const FVector& InCameraPosition )
+{
+    auto requester = FindRequester( InHandle );
+    if ( requester == nullptr )
+        return false;
+
+    requester->Position = InCameraPosition;
+    if ( !requester->Pending ) {
+        requester->Pending = true;
+        PendingIndices.Add( InHandle.Index );
+    }
+
+    return true;
+}
+
+bool UVXRCalibrationQueryService::GetCorrection( const FVXRCorrectionHandle& InHandle, FRotator& OutRotation )
+{
+    auto requester = FindRequester( InHandle );
+    if ( requester == nullptr )
+        return false;
+
+    if ( requester->Pending )
+        ResolvePendingRequests();
+
+    OutRotation = requester->Result;
+    return true;
+}
+
+void UVXRCalibrationQueryService::ResolvePendingRequests()
+{
+    if ( PendingIndices.Num() == 0 )
+        return;
+
+    SCOPE_CYCLE_COUNTER( STAT_VXRResolveCorrectionBatch );
+    INC_DWORD_STAT_BY( STAT_VXRCorrectionRequests, PendingIndices.Num() );
+
+    // Resolve weak pointers on the game thread, workers only see raw pointers.
+    TArray<TPair<AVXROctreeController*, FRequester*>, TInlineAllocator<16>> batch;
+    for ( auto index : PendingIndices ) {
+        auto& requester = Requesters[index];
+        requester.Pending = false;
+
+        auto controller = requester.Controller.Get();
+        if ( controller != nullptr )
+            batch.Emplace( controller, &requester );
+        else
+            requester.Result = FRotator::ZeroRotator;
+    }
+    PendingIndices.Reset();
+
+    ParallelFor( batch.Num(), [&batch]( int32 InIndex ){
+            auto requester = batch[InIndex].Value;
+            requester->Result = batch[InIndex].Key->GetCollectCameraRotation( requester->Position, requester->Cache );
+        }, batch.Num() < ParallelThreshold );
+}
+
+void UVXRCalibrationQueryService::Deinitialize()
+{
+    PendingIndices.Empty();
+    Requesters.Empty();
+
+    Super::Deinitialize();
+}
+
+void UVXRCalibrationQueryService::Tick( float DeltaTime )
+{
+    ResolvePendingRequests();
+}
+
+bool UVXRCalibrationQueryService::IsTickable() const
+{
+    return !IsTemplate() && PendingIndices.Num() > 0;
+}
+
+TStatId UVXRCalibrationQueryService::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT( UVXRCalibrationQueryService, STATGROUP_Tickables );
+}
@@ -0,0 +1,243 @@
+#include "VXRCalibrationTextCodec.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "VXRLog.h"
+
+const TCHAR* FVXRCalibrationTextCodec::LinePrefix = TEXT( "OctreeElement[Position, Yaw, Pitch]:" );
+int32 FVXRCalibrationTextCodec::ChunkSize = 256 * 1024;
+
+namespace
+{
+    const ANSICHAR AnsiLinePrefix[] = "OctreeElement[Position, Yaw, Pitch]:";
+    const int32 LinePrefixLength = UE_ARRAY_COUNT( AnsiLinePrefix ) - 1;
+    const int32 MaxNumberLength = 63;
+
+    struct FChunkResult
+    {
+        TArray<FVXRCameraData> CameraDatas;
+        TArray<int32> MalformedLines;
+        int32 LineCount = 0;
+        int32 MalformedLineCount = 0;
+    };
+
+    template<typename CharType>
+    bool IsBlank( CharType InChar )
+    {
+        return InChar == ' ' || InChar == '\t' || InChar == '\r';
+    }
+
+    template<typename CharType>
+    bool ParseNumber( const CharType*& InOutCursor, const CharType* InEnd, float& OutValue )
+    {
+        while ( InOutCursor < InEnd && IsBlank( *InOutCursor ) )
+            ++InOutCursor;
+
+        // Copy the token to a small stack buffer so Atod never reads past the line.
+        ANSICHAR token[MaxNumberLength + 1];
+        int32 length = 0;
+        bool hasDigit = false;
+        while ( InOutCursor < InEnd && length < MaxNumberLength ) {
+            auto ch = *InOutCursor;
+            if ( ch >= '0' && ch <= '9' )
+                hasDigit = true;
+            else if ( ch != '+' && ch != '-' && ch != '.' && ch != 'e' && ch != 'E' )
+                break;
+
+            token[length++] = (ANSICHAR)ch;
+            ++InOutCursor;
+        }
+        token[length] = '\0';
+
+        while ( InOutCursor < InEnd && IsBlank( *InOutCursor ) )
+            ++InOutCursor;
+
+        if ( !hasDigit )
+            return false;
+
+        OutValue = (float)FCStringAnsi::Atod( token );
+        return true;
+    }
+
+    template<typename CharType>
+    bool ParseLine( const CharType* InBegin, const CharType* InEnd, FVXRCameraData& OutCameraData )
+    {
+        if ( InEnd - InBegin < LinePrefixLength )
+            return false;
+
+        for ( int32 i = 0; i < LinePrefixLength; ++i ) {
+            if ( InBegin[i] != (CharType)AnsiLinePrefix[i] )
+                return false;
+        }
+
+        float values[5];
+        auto cursor = InBegin + LinePrefixLength;
+        for ( int32 i = 0; i < 5; ++i ) {
+            if ( !ParseNumber( cursor, InEnd, values[i] ) )
+                return false;
+
+            if ( i < 4 ) {
+                if ( cursor >= InEnd || *cursor != ',' )
+                    return false;
+                ++cursor;
+            }
+        }
+
+        // Trailing fields were tolerated by the original parser, keep accepting them.
+        if ( cursor < InEnd && *cursor != ',' )
+            return false;
+
+        OutCameraData.Position = FVector( values[0], values[1], values[2] );
+        OutCameraData.OffsetYaw = values[3];
+        OutCameraData.OffsetPitch = values[4];
+        return true;
+    }
+
+    template<typename CharType>
+    void ParseChunk( const CharType* InBegin, const CharType* InEnd, FChunkResult& OutResult )
+    {
+        OutResult.CameraDatas.Reserve( (int32)(InEnd - InBegin) / 64 );
+
+        auto lineBegin = InBegin;
+        while ( lineBegin < InEnd ) {
+            auto lineEnd = lineBegin;
+            while ( lineEnd < InEnd && *lineEnd != '\n' )
+                ++lineEnd;
+
+            ++OutResult.LineCount;
+
+            auto trimmedEnd = lineEnd;
+            while ( trimmedEnd > lineBegin && IsBlank( *(trimmedEnd - 1) ) )
+                --trimmedEnd;
+
+            if ( trimmedEnd > lineBegin ) {
+                FVXRCameraData camData;
+                if ( ParseLine( lineBegin, trimmedEnd, camData ) ) {
+                    OutResult.CameraDatas.Add( camData );
+                }
+                else {
+                    ++OutResult.MalformedLineCount;
+                    if ( OutResult.MalformedLines.Num() < FVXRTextParseReport::MaxReportedLines )
+                        OutResult.MalformedLines.Add( OutResult.LineCount );
+                }
+            }
+
+            lineBegin = lineEnd + 1;
+        }
+    }
+
+    template<typename CharType>
+    void ParseBuffer( const CharType* InBegin, const CharType* InEnd, TArray<FVXRCameraData>& OutCameraDatas,
+        FVXRTextParseReport& OutReport )
+    {
+        // Split into chunks that always end right after a newline, so no line straddles two chunks.
+        TArray<TPair<const CharType*, const CharType*>> chunks;
+        auto chunkSize = FMath::Max( FVXRCalibrationTextCodec::ChunkSize, 1024 );
+        auto chunkBegin = InBegin;
+        while ( chunkBegin < InEnd ) {
+            auto chunkEnd = chunkBegin + FMath::Min<int64>( chunkSize, InEnd - chunkBegin );
+            while ( chunkEnd < InEnd && *(chunkEnd - 1) != '\n' )
+                ++chunkEnd;
+
+            chunks.Emplace( chunkBegin, chunkEnd );
+            chunkBegin = chunkEnd;
+        }
+
+        TArray<FChunkResult> results;
+        results.SetNum( chunks.Num() );
+        ParallelFor( chunks.Num(), [&chunks, &results]( int32 InIndex ){
+                ParseChunk( chunks[InIndex].Key, chunks[InIndex].Value, results[InIndex] );
+            }, chunks.Num() < 2 );
+
+        int32 totalSamples = 0;
+        for ( auto& result : results )
+            totalSamples += result.CameraDatas.Num();
+        OutCameraDatas.Reserve( OutCameraDatas.Num() + totalSamples );
+
+        for ( auto& result : results ) {
+            for ( auto line : result.MalformedLines ) {
+                if ( OutReport.MalformedLines.Num() < FVXRTextParseReport::MaxReportedLines )
+                    OutReport.MalformedLines.Add( OutReport.LineCount + line );
+            }
+
+            OutCameraDatas.Append( result.CameraDatas );
+            OutReport.LineCount += result.LineCount;
+            OutReport.SampleCount += result.CameraDatas.Num();
+            OutReport.MalformedLineCount += result.MalformedLineCount;
+        }
+    }
+
+    void LogReport( const FString& InSource, const FVXRTextParseReport& InReport )
+    {
+        VXR_LOG( Log, TEXT( "#### Parsed calibration text. Source:[%s] Lines:[%d] Samples:[%d] ####" ),
+            *InSource, InReport.LineCount, InReport.SampleCount );
+
+        if ( InReport.MalformedLineCount > 0 ) {
+            FString lines;
+            for ( auto line : InReport.MalformedLines )
+                lines += FString::Printf( TEXT( "%s%d" ), lines.IsEmpty() ? TEXT( "" ) : TEXT( "," ), line );
+
+            VXR_LOG( Warning, TEXT( "#### Malformed calibration lines. Source:[%s] Count:[%d] First Lines:[%s] ####" ),
+                *InSource, InReport.MalformedLineCount, *lines );
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool FVXRCalibrationTextCodec::LoadFile( const FString& InFilePath, TArray<FVXRCameraData>& OutCameraDatas,
+    FVXRTextParseReport& OutReport )
+{
+    TArray<uint8> buffer;
+    if ( !FFileHelper::LoadFileToArray( buffer, *InFilePath ) ) {
+        VXR_LOG( Warning, TEXT( "#### Cannot load calibration text file. File Path:[%s] ####" ), *InFilePath );
+        return false;
+    }
+
+    OutReport = FVXRTextParseReport();
+
+    auto size = buffer.Num();
+    auto bytes = buffer.GetData();
+    if ( size >= 2 && ((bytes[0] == 0xFF && bytes[1] == 0xFE) || (bytes[0] == 0xFE && bytes[1] == 0xFF)) ) {
+        // UTF-16 files are rare for this format, let the engine convert them.
+        FString text;
+        FFileHelper::BufferToString( text, bytes, size );
+        ParseBuffer( *text, *text + text.Len(), OutCameraDatas, OutReport );
+    }
+    else {
+        auto begin = (const ANSICHAR*)bytes;
+        if ( size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF )
+            begin += 3;
+        ParseBuffer( begin, (const ANSICHAR*)bytes + size, OutCameraDatas, OutReport );
+    }
+
+    LogReport( InFilePath, OutReport );
+    return true;
+}
+
+void FVXRCalibrationTextCodec::Parse( const FString& InText, TArray<FVXRCameraData>& OutCameraDatas, FVXRTextParseReport& OutReport )
+{
+    OutReport = FVXRTextParseReport();
+    ParseBuffer( *InText, *InText + InText.Len(), OutCameraDatas, OutReport );
+    LogReport( TEXT( "String" ), OutReport );
+}
+
+const FString& FVXRCalibrationTextCodec::Write( const TArray<FVXRCameraData>& InCameraDatas )
+{
+    WriteBuffer.Reset( InCameraDatas.Num() * 96 );
+
+    TCHAR line[256];
+    for ( auto& data : InCameraDatas ) {
+        auto length = FCString::Snprintf( line, UE_ARRAY_COUNT( line ), TEXT( "%s%f,%f,%f,%f,%f" LINE_TERMINATOR ), LinePrefix,
+            data.Position.X, data.Position.Y, data.Position.Z, data.OffsetYaw, data.OffsetPitch );
+        WriteBuffer.AppendChars( line, FMath::Clamp( length, 0, (int32)UE_ARRAY_COUNT( line ) - 1 ) );
+    }
+
+    return WriteBuffer;
+}
+
+bool FVXRCalibrationTextCodec::SaveFile( const FString& InFilePath, const TArray<FVXRCameraData>& InCameraDatas )
+{
+    auto successed = FFileHelper::SaveStringToFile( Write( InCameraDatas ), *InFilePath );
+    VXR_CLOG( !successed, Warning, TEXT( "#### Cannot save calibration text file. File Path:[%s] ####" ), *InFilePath );
+    return successed;
+}
@@ -0,0 +1,66 @@
+#include "VXRCompactOctreeSpatialIndex.h"
+#include "VXROctreeTemplate.h"
+#include "VXRLog.h"
+
+FVXRCompactOctreeSpatialIndex::FVXRCompactOctreeSpatialIndex( const FVector& InOrigin, const FVector& InExtent, int32 InMaxDepth )
+    : Octree( MakeUnique<TVXROctree<LeafCapacity, FVXRCameraData>>( InOrigin, InExtent, InMaxDepth ) )
+{
+}
+
+FVXRCompactOctreeSpatialIndex::~FVXRCompactOctreeSpatialIndex()
+{
+}
+
+bool FVXRCompactOctreeSpatialIndex::Insert( const FVXRCameraData& InCameraData )
+{
+    if ( Octree->Insert( InCameraData ) )
+        return true;
+
+    VXR_LOG( Verbose, TEXT( "#### Cannot be inserted to the compact octree, outside of the bounds. Position:[%s] ####" ),
+        *InCameraData.Position.ToString() );
+    return false;
+}
+
+bool FVXRCompactOctreeSpatialIndex::Remove( const FVector& InPosition, float InTolerance )
+{
+    return Octree->Remove( InPosition, InTolerance );
+}
+
+int32 FVXRCompactOctreeSpatialIndex::FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const
+{
+    return Octree->FindNearest( InPosition, OutCameraDatas, InCount );
+}
+
+void FVXRCompactOctreeSpatialIndex::QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    Octree->QueryBox( InBox, OutCameraDatas );
+}
+
+void FVXRCompactOctreeSpatialIndex::GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    OutCameraDatas.Reserve( OutCameraDatas.Num() + Octree->Num() );
+    Octree->ForEachLeaf( [&OutCameraDatas]( const FVector&, const FVector&, const FVXRCameraData* InItems, int32 InCount ){
+            OutCameraDatas.Append( InItems, InCount );
+        } );
+}
+
+void FVXRCompactOctreeSpatialIndex::GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const
+{
+    Octree->ForEachLeaf( [&OutBlocks]( const FVector& InOrigin, const FVector& InExtent, const FVXRCameraData* InItems, int32 InCount ){
+            auto& block = OutBlocks.AddDefaulted_GetRef();
+            block.Origin = InOrigin;
+            block.Extent = InExtent;
+            for ( int32 i = 0; i < InCount; ++i )
+                block.Samples.Add( FVXRPackedSample::Encode( InItems[i].Position, InItems[i].OffsetYaw, InItems[i].OffsetPitch, InOrigin, InExtent ) );
+        } );
+}
+
+int32 FVXRCompactOctreeSpatialIndex::Num() const
+{
+    return Octree->Num();
+}
+
+const TCHAR* FVXRCompactOctreeSpatialIndex::GetName() const
+{
+    return TEXT( "CompactOctree" );
+}
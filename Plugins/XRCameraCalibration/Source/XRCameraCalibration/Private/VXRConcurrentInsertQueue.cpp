@@ -0,0 +1,56 @@
+#include "VXRConcurrentInsertQueue.h"
+#include "VXRSpatialIndex.h"
+
+FVXRConcurrentInsertQueue::FVXRConcurrentInsertQueue( int32 InCapacity )
+    : Capacity( FMath::Max( InCapacity, 1 ) )
+{
+}
+
+bool FVXRConcurrentInsertQueue::Enqueue( const FVXRCameraData& InCameraData )
+{
+    // The slot is reserved before the sample is queued, so concurrent writers never overshoot the capacity.
+    if ( PendingCount.Increment() > Capacity ) {
+        PendingCount.Decrement();
+        return false;
+    }
+
+    Queue.Enqueue( InCameraData );
+    return true;
+}
+
+int32 FVXRConcurrentInsertQueue::GetPendingCount() const
+{
+    return PendingCount.GetValue();
+}
+
+void FVXRConcurrentInsertQueue::SetCapacity( int32 InCapacity )
+{
+    Capacity = FMath::Max( InCapacity, 1 );
+}
+
+int32 FVXRConcurrentInsertQueue::Drain( IVXRSpatialIndex& InIndex, int32 InMaxCount, int32& OutRejectedCount )
+{
+    auto drained = 0;
+    auto inserted = 0;
+    FVXRCameraData data;
+    while ( drained < InMaxCount && Queue.Dequeue( data ) ) {
+        if ( InIndex.Insert( data ) )
+            ++inserted;
+        ++drained;
+    }
+
+    PendingCount.Subtract( drained );
+    OutRejectedCount = drained - inserted;
+    return inserted;
+}
+
+int32 FVXRConcurrentInsertQueue::Reset()
+{
+    auto dropped = 0;
+    FVXRCameraData data;
+    while ( Queue.Dequeue( data ) )
+        ++dropped;
+
+    PendingCount.Subtract( dropped );
+    return dropped;
+}
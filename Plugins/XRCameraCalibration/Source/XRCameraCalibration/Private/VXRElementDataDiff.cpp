@@ -0,0 +1,70 @@
+#include "VXRElementDataDiff.h"
+
+namespace
+{
+    // Half float offsets in the packed storage are exact to about 1e-3 in the usual range.
+    const float OffsetTolerance = 0.005f;
+
+    void AddChange( TArray<FVXRElementDataChange>& OutChanges, const FVXRCameraData& InCameraData, const FVXRCameraData& InLiveCameraData,
+        EVXRElementDataChangeType InType )
+    {
+        auto& change = OutChanges.AddDefaulted_GetRef();
+        change.CameraData = InCameraData;
+        change.LiveCameraData = InLiveCameraData;
+        change.Type = InType;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+FIntVector VXRElementDataDiff::GetPositionKey( const FVector& InPosition, float InKeyResolution )
+{
+    auto resolution = FMath::Max( InKeyResolution, KINDA_SMALL_NUMBER );
+    return FIntVector( FMath::RoundToInt( InPosition.X / resolution ), FMath::RoundToInt( InPosition.Y / resolution ),
+        FMath::RoundToInt( InPosition.Z / resolution ) );
+}
+
+void VXRElementDataDiff::Diff( const TArray<FVXRCameraData>& InLiveDatas, const TArray<FVXRCameraData>& InNewDatas, 
+    float InKeyResolution, TArray<FVXRElementDataChange>& OutChanges )
+{
+    auto resolution = FMath::Max( InKeyResolution, KINDA_SMALL_NUMBER );
+
+    TMap<FIntVector, int32> liveKeys;
+    liveKeys.Reserve( InLiveDatas.Num() );
+    for ( int32 i = 0; i < InLiveDatas.Num(); ++i ) {
+        auto key = GetPositionKey( InLiveDatas[i].Position, resolution );
+        if ( liveKeys.Contains( key ) )
+            AddChange( OutChanges, InLiveDatas[i], InLiveDatas[i], EVXRElementDataChangeType::Remove );
+        else
+            liveKeys.Add( key, i );
+    }
+
+    TSet<FIntVector> newKeys;
+    newKeys.Reserve( InNewDatas.Num() );
+    for ( auto& data : InNewDatas ) {
+        auto key = GetPositionKey( data.Position, resolution );
+        if ( newKeys.Contains( key ) )
+            continue;
+        newKeys.Add( key );
+
+        auto liveIdx = liveKeys.Find( key );
+        if ( liveIdx == nullptr ) {
+            AddChange( OutChanges, data, data, EVXRElementDataChangeType::Insert );
+            continue;
+        }
+
+        auto& live = InLiveDatas[*liveIdx];
+        if ( !FMath::IsNearlyEqual( live.OffsetYaw, data.OffsetYaw, OffsetTolerance ) || 
+             !FMath::IsNearlyEqual( live.OffsetPitch, data.OffsetPitch, OffsetTolerance ) ) {
+            // The live position is kept so the remove half finds the stored sample.
+            auto updated = data;
+            updated.Position = live.Position;
+            AddChange( OutChanges, updated, live, EVXRElementDataChangeType::Update );
+        }
+    }
+
+    for ( auto& live : liveKeys ) {
+        if ( !newKeys.Contains( live.Key ) )
+            AddChange( OutChanges, InLiveDatas[live.Value], InLiveDatas[live.Value], EVXRElementDataChangeType::Remove );
+    }
+}
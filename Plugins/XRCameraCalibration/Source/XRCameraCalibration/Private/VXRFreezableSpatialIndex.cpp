@@ -0,0 +1,185 @@
+#include "VXRFreezableSpatialIndex.h"
+#include "VXRLog.h"
+
+namespace
+{
+    // Removes every sample by the position the index reports for it, which is the position it compares
+    // against on remove (e.g. the decoded one for packed leaves). Returns how many samples are left.
+    int32 RemoveAll( IVXRSpatialIndex& InOutIndex )
+    {
+        TArray<FVXRCameraData> cameraDatas;
+        InOutIndex.GetCameraDatas( cameraDatas );
+        for ( auto& data : cameraDatas )
+            InOutIndex.Remove( data.Position, KINDA_SMALL_NUMBER );
+
+        return InOutIndex.Num();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+FVXRFreezableSpatialIndex::FVXRFreezableSpatialIndex( TUniquePtr<IVXRSpatialIndex>&& InDynamicIndex )
+    : DynamicIndex( MoveTemp( InDynamicIndex ) )
+    , Frozen( false )
+    , DynamicIndexStale( false )
+    , ThawFailed( false )
+{
+    check( DynamicIndex.IsValid() );
+}
+
+void FVXRFreezableSpatialIndex::Freeze()
+{
+    if ( Frozen )
+        return;
+
+    TArray<FVXRCameraData> cameraDatas;
+    DynamicIndex->GetCameraDatas( cameraDatas );
+    FrozenIndex.Build( cameraDatas );
+    Frozen = true;
+    ThawFailed = false;
+
+    VXR_LOG( Log, TEXT( "#### Freeze spatial index. Index:[%s] Samples:[%d] Nodes:[%d] Size:[%llu bytes] ####" ),
+        DynamicIndex->GetName(), FrozenIndex.Num(), FrozenIndex.GetNodeCount(), (uint64)FrozenIndex.GetAllocatedSize() );
+}
+
+void FVXRFreezableSpatialIndex::Freeze( FVXRStaticKdTree&& InKdTree )
+{
+    // The prebuilt tree replaces the dynamic content, so the next thaw refills an empty index.
+    if ( !DynamicIndexStale ) {
+        Thaw();
+        auto remaining = RemoveAll( *DynamicIndex );
+        VXR_CLOG( remaining > 0, Warning, TEXT( "#### Cannot clear dynamic spatial index. Index:[%s] Remaining:[%d] ####" ),
+            DynamicIndex->GetName(), remaining );
+    }
+
+    FrozenIndex = MoveTemp( InKdTree );
+    Frozen = true;
+    DynamicIndexStale = true;
+    ThawFailed = false;
+
+    VXR_LOG( Log, TEXT( "#### Freeze spatial index with prebuilt tree. Index:[%s] Samples:[%d] Nodes:[%d] ####" ),
+        DynamicIndex->GetName(), FrozenIndex.Num(), FrozenIndex.GetNodeCount() );
+}
+
+bool FVXRFreezableSpatialIndex::Thaw()
+{
+    if ( !Frozen )
+        return true;
+
+    // The same tree fails the same way again, so later edits are rejected without another refill.
+    if ( ThawFailed )
+        return false;
+
+    if ( DynamicIndexStale ) {
+        auto samples = FrozenIndex.GetSamples();
+        int32 failed = 0;
+        for ( int32 i = 0; i < FrozenIndex.Num(); ++i ) {
+            if ( !DynamicIndex->Insert( samples[i] ) )
+                ++failed;
+        }
+
+        if ( failed > 0 ) {
+            // A lossy thaw would silently drop calibration, so empty the partial refill and stay frozen.
+            auto remaining = RemoveAll( *DynamicIndex );
+            ThawFailed = true;
+
+            VXR_LOG( Warning, TEXT( "#### Cannot thaw spatial index, the dynamic index rejected samples. Index:[%s] Rejected:[%d/%d] Remaining:[%d] ####" ),
+                DynamicIndex->GetName(), failed, FrozenIndex.Num(), remaining );
+            return false;
+        }
+        DynamicIndexStale = false;
+    }
+
+    FrozenIndex.Reset();
+    Frozen = false;
+
+    VXR_LOG( Log, TEXT( "#### Thaw spatial index. Index:[%s] ####" ), DynamicIndex->GetName() );
+    return true;
+}
+
+bool FVXRFreezableSpatialIndex::IsFrozen() const
+{
+    return Frozen;
+}
+
+IVXRSpatialIndex* FVXRFreezableSpatialIndex::GetDynamicIndex() const
+{
+    return DynamicIndex.Get();
+}
+
+const FVXRStaticKdTree& FVXRFreezableSpatialIndex::GetFrozenIndex() const
+{
+    return FrozenIndex;
+}
+
+bool FVXRFreezableSpatialIndex::Insert( const FVXRCameraData& InCameraData )
+{
+    if ( !Thaw() )
+        return false;
+
+    return DynamicIndex->Insert( InCameraData );
+}
+
+bool FVXRFreezableSpatialIndex::Remove( const FVector& InPosition, float InTolerance )
+{
+    if ( !Thaw() )
+        return false;
+
+    return DynamicIndex->Remove( InPosition, InTolerance );
+}
+
+int32 FVXRFreezableSpatialIndex::FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const
+{
+    if ( Frozen )
+        return FrozenIndex.FindNearest( InPosition, OutCameraDatas, InCount );
+
+    return DynamicIndex->FindNearest( InPosition, OutCameraDatas, InCount );
+}
+
+void FVXRFreezableSpatialIndex::QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( Frozen )
+        FrozenIndex.QueryBox( InBox, OutCameraDatas );
+    else
+        DynamicIndex->QueryBox( InBox, OutCameraDatas );
+}
+
+void FVXRFreezableSpatialIndex::GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( Frozen )
+        OutCameraDatas.Append( FrozenIndex.GetSamples(), FrozenIndex.Num() );
+    else
+        DynamicIndex->GetCameraDatas( OutCameraDatas );
+}
+
+void FVXRFreezableSpatialIndex::GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const
+{
+    if ( DynamicIndexStale ) {
+        // Single block over the tree bounds, the dynamic index has not been filled yet.
+        auto samples = FrozenIndex.GetSamples();
+        FBox bounds( ForceInit );
+        for ( int32 i = 0; i < FrozenIndex.Num(); ++i )
+            bounds += samples[i].Position;
+
+        if ( bounds.IsValid ) {
+            auto& block = OutBlocks.AddDefaulted_GetRef();
+            block.Origin = bounds.GetCenter();
+            block.Extent = bounds.GetExtent();
+            for ( int32 i = 0; i < FrozenIndex.Num(); ++i )
+                block.Samples.Add( FVXRPackedSample::Encode( samples[i].Position, samples[i].OffsetYaw, samples[i].OffsetPitch, block.Origin, block.Extent ) );
+        }
+        return;
+    }
+
+    DynamicIndex->GetPackedSampleBlocks( OutBlocks );
+}
+
+int32 FVXRFreezableSpatialIndex::Num() const
+{
+    return Frozen ? FrozenIndex.Num() : DynamicIndex->Num();
+}
+
+const TCHAR* FVXRFreezableSpatialIndex::GetName() const
+{
+    return Frozen ? TEXT( "StaticKdTree" ) : DynamicIndex->GetName();
+}
@@ -0,0 +1,229 @@
+#include "VXRHashGridSpatialIndex.h"
+#include "VXRLog.h"
+
+namespace
+{
+    typedef IVXRSpatialIndex::TNearestList<FVXRCameraData> FNearestList;
+}
+
+//-----------------------------------------------------------------------------
+
+FVXRHashGridSpatialIndex::FVXRHashGridSpatialIndex( float InCellSize )
+    : CellSize( FMath::Max( InCellSize, 1.0f ) )
+    , SampleCount( 0 )
+    , MinKey( FIntVector::ZeroValue )
+    , MaxKey( FIntVector::ZeroValue )
+{
+}
+
+FIntVector FVXRHashGridSpatialIndex::GetCellKey( const FVector& InPosition ) const
+{
+    return FIntVector( FMath::FloorToInt( InPosition.X / CellSize ), FMath::FloorToInt( InPosition.Y / CellSize ),
+        FMath::FloorToInt( InPosition.Z / CellSize ) );
+}
+
+FVector FVXRHashGridSpatialIndex::GetCellOrigin( const FIntVector& InKey ) const
+{
+    return (FVector( InKey.X, InKey.Y, InKey.Z ) + FVector( 0.5f )) * CellSize;
+}
+
+FVector FVXRHashGridSpatialIndex::GetCellExtent() const
+{
+    return FVector( CellSize * 0.5f );
+}
+
+float FVXRHashGridSpatialIndex::GetCellSize() const
+{
+    return CellSize;
+}
+
+bool FVXRHashGridSpatialIndex::Insert( const FVXRCameraData& InCameraData )
+{
+    auto key = GetCellKey( InCameraData.Position );
+    auto& cell = Cells.FindOrAdd( key );
+    cell.Add( FVXRPackedSample::Encode( InCameraData.Position, InCameraData.OffsetYaw, InCameraData.OffsetPitch,
+        GetCellOrigin( key ), GetCellExtent() ) );
+
+    if ( SampleCount == 0 ) {
+        MinKey = key;
+        MaxKey = key;
+    }
+    else {
+        MinKey = FIntVector( FMath::Min( MinKey.X, key.X ), FMath::Min( MinKey.Y, key.Y ), FMath::Min( MinKey.Z, key.Z ) );
+        MaxKey = FIntVector( FMath::Max( MaxKey.X, key.X ), FMath::Max( MaxKey.Y, key.Y ), FMath::Max( MaxKey.Z, key.Z ) );
+    }
+
+    ++SampleCount;
+    return true;
+}
+
+bool FVXRHashGridSpatialIndex::Remove( const FVector& InPosition, float InTolerance )
+{
+    auto minKey = GetCellKey( InPosition - FVector( InTolerance ) );
+    auto maxKey = GetCellKey( InPosition + FVector( InTolerance ) );
+
+    TArray<FVXRPackedSample>* foundCell = nullptr;
+    FIntVector foundKey;
+    int32 foundIdx = INDEX_NONE;
+    float bestDistSq = FMath::Square( InTolerance );
+
+    for ( int32 x = minKey.X; x <= maxKey.X; ++x ) {
+        for ( int32 y = minKey.Y; y <= maxKey.Y; ++y ) {
+            for ( int32 z = minKey.Z; z <= maxKey.Z; ++z ) {
+                auto key = FIntVector( x, y, z );
+                auto cell = Cells.Find( key );
+                if ( cell == nullptr )
+                    continue;
+
+                auto origin = GetCellOrigin( key );
+                for ( int32 i = 0; i < cell->Num(); ++i ) {
+                    auto distSq = FVector::DistSquared( InPosition, (*cell)[i].DecodePosition( origin, GetCellExtent() ) );
+                    if ( distSq <= bestDistSq ) {
+                        bestDistSq = distSq;
+                        foundCell = cell;
+                        foundKey = key;
+                        foundIdx = i;
+                    }
+                }
+            }
+        }
+    }
+
+    if ( foundCell == nullptr )
+        return false;
+
+    foundCell->RemoveAtSwap( foundIdx );
+    if ( foundCell->Num() == 0 )
+        Cells.Remove( foundKey );
+
+    --SampleCount;
+    return true;
+}
+
+int32 FVXRHashGridSpatialIndex::FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const
+{
+    if ( InCount <= 0 || SampleCount == 0 )
+        return 0;
+
+    FNearestList nearest;
+    auto extent = GetCellExtent();
+    auto scanCell = [&]( const FIntVector& InKey, const TArray<FVXRPackedSample>& InCell ){
+        auto origin = GetCellOrigin( InKey );
+        for ( auto& sample : InCell ) {
+            auto data = sample.Decode( origin, extent );
+            IVXRSpatialIndex::AddNearestCandidate( nearest, InCount, FVector::DistSquared( InPosition, data.Position ), data );
+        }
+    };
+
+    auto center = GetCellKey( InPosition );
+    auto maxRing = FMath::Max3( FMath::Max( FMath::Abs( center.X - MinKey.X ), FMath::Abs( MaxKey.X - center.X ) ),
+        FMath::Max( FMath::Abs( center.Y - MinKey.Y ), FMath::Abs( MaxKey.Y - center.Y ) ),
+        FMath::Max( FMath::Abs( center.Z - MinKey.Z ), FMath::Abs( MaxKey.Z - center.Z ) ) );
+
+    // Visit shells of cells around the query cell. A sample in shell r is at least (r - 1) cells away,
+    // so stop once that bound exceeds the current k-th distance. Very sparse grids fall back to a flat scan.
+    int32 probes = 0;
+    bool completed = true;
+    for ( int32 ring = 0; ring <= maxRing; ++ring ) {
+        if ( nearest.Num() == InCount && ring > 0 && FMath::Square( (ring - 1) * CellSize ) > nearest.Last().Key )
+            break;
+
+        if ( probes > Cells.Num() ) {
+            completed = false;
+            break;
+        }
+
+        for ( int32 x = -ring; x <= ring; ++x ) {
+            for ( int32 y = -ring; y <= ring; ++y ) {
+                auto onShell = FMath::Abs( x ) == ring || FMath::Abs( y ) == ring;
+                auto zStep = onShell ? 1 : FMath::Max( 2 * ring, 1 );
+                for ( int32 z = -ring; z <= ring; z += zStep ) {
+                    ++probes;
+                    auto key = center + FIntVector( x, y, z );
+                    auto cell = Cells.Find( key );
+                    if ( cell != nullptr )
+                        scanCell( key, *cell );
+                }
+            }
+        }
+    }
+
+    if ( !completed ) {
+        nearest.Reset();
+        for ( auto& cell : Cells )
+            scanCell( cell.Key, cell.Value );
+    }
+
+    for ( int32 i = 0; i < nearest.Num(); ++i )
+        OutCameraDatas[i] = nearest[i].Value;
+
+    return nearest.Num();
+}
+
+void FVXRHashGridSpatialIndex::QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    auto extent = GetCellExtent();
+    auto queryCell = [&]( const FIntVector& InKey, const TArray<FVXRPackedSample>& InCell ){
+        auto origin = GetCellOrigin( InKey );
+        auto cellBox = FBox::BuildAABB( origin, extent );
+        if ( !InBox.Intersect( cellBox ) )
+            return;
+
+        auto contained = InBox.IsInsideOrOn( cellBox.Min ) && InBox.IsInsideOrOn( cellBox.Max );
+        for ( auto& sample : InCell ) {
+            auto data = sample.Decode( origin, extent );
+            if ( contained || InBox.IsInsideOrOn( data.Position ) )
+                OutCameraDatas.Add( data );
+        }
+    };
+
+    auto minKey = GetCellKey( InBox.Min );
+    auto maxKey = GetCellKey( InBox.Max );
+    auto range = FIntVector( maxKey.X - minKey.X + 1, maxKey.Y - minKey.Y + 1, maxKey.Z - minKey.Z + 1 );
+    if ( (int64)range.X * range.Y * range.Z > Cells.Num() ) {
+        for ( auto& cell : Cells )
+            queryCell( cell.Key, cell.Value );
+        return;
+    }
+
+    for ( int32 x = minKey.X; x <= maxKey.X; ++x ) {
+        for ( int32 y = minKey.Y; y <= maxKey.Y; ++y ) {
+            for ( int32 z = minKey.Z; z <= maxKey.Z; ++z ) {
+                auto key = FIntVector( x, y, z );
+                auto cell = Cells.Find( key );
+                if ( cell != nullptr )
+                    queryCell( key, *cell );
+            }
+        }
+    }
+}
+
+void FVXRHashGridSpatialIndex::GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    OutCameraDatas.Reserve( OutCameraDatas.Num() + SampleCount );
+    for ( auto& cell : Cells ) {
+        auto origin = GetCellOrigin( cell.Key );
+        for ( auto& sample : cell.Value )
+            OutCameraDatas.Add( sample.Decode( origin, GetCellExtent() ) );
+    }
+}
+
+void FVXRHashGridSpatialIndex::GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const
+{
+    for ( auto& cell : Cells ) {
+        auto& block = OutBlocks.AddDefaulted_GetRef();
+        block.Origin = GetCellOrigin( cell.Key );
+        block.Extent = GetCellExtent();
+        block.Samples = cell.Value;
+    }
+}
+
+int32 FVXRHashGridSpatialIndex::Num() const
+{
+    return SampleCount;
+}
+
+const TCHAR* FVXRHashGridSpatialIndex::GetName() const
+{
+    return TEXT( "HashGrid" );
+}
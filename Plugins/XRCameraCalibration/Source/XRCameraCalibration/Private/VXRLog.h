@@ -1,8 +1,10 @@
 // Copyright ViveStudios. All Rights Reserved.
 #pragma once
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 DECLARE_LOG_CATEGORY_EXTERN( LogVXR, Log, All )
+DECLARE_STATS_GROUP( TEXT( "VXR" ), STATGROUP_VXR, STATCAT_Advanced );
 
 #define VXR_LOG_CALLINFO                              (FString( TEXT( "[" ) ) + FString( __FUNCTION__ ) + TEXT( "(" ) + FString::FromInt( __LINE__ ) + TEXT( ")" ) + FString( TEXT( "]" ) ) )
 #define VXR_LOG_CALLONLY( Verbosity )                 UE_LOG( LogVXR, Verbosity, TEXT( "%s" ), *VXR_LOG_CALLINFO )
@@ -1,5 +1,7 @@
 #include "VXROctree.h"
 #include "VXROctreeElement.h"
+#include "VXROctreeOctant.h"
+#include "VXRSpatialIndex.h"
 #include "DrawDebugHelpers.h"
 #include "VXRLog.h"
 
@@ -7,6 +9,8 @@ int32 AVXROctree::MaxDepth = 0;
 int32 AVXROctree::MaxElements = 0;
 float AVXROctree::DrawLifeTime = 0.0f;
 FColor AVXROctree::NodeColor;
+bool AVXROctree::SpawnElementActors = false;
+bool AVXROctree::KeepExactSamples = false;
 
 //-----------------------------------------------------------------------------
 
@@ -19,7 +23,8 @@ AVXROctree::AVXROctree( const FObjectInitializer& ObjectInitializer )
 }
 
 AVXROctree* AVXROctree::SpawnRootOctree( UObject* InWorldContextObject, const FVector& InSpawnLocation, const FVector& InSpawnExtent, 
-    TSubclassOf<AVXROctreeElement> InElementClass, int32 InMaxElements, int32 InMaxDepth, float InDrawLifeTime, FColor InNodeColor )
+    TSubclassOf<AVXROctreeElement> InElementClass, int32 InMaxElements, int32 InMaxDepth, float InDrawLifeTime, FColor InNodeColor, 
+    bool InSpawnElementActors, bool InKeepExactSamples )
 {
     auto world = InWorldContextObject != nullptr ? InWorldContextObject->GetWorld() : nullptr;
     if ( ensure( world != nullptr ) ) {
@@ -30,6 +35,8 @@ AVXROctree* AVXROctree::SpawnRootOctree( UObject* InWorldContextObject, const FV
             AVXROctree::MaxDepth = InMaxDepth;
             AVXROctree::DrawLifeTime = InDrawLifeTime;
             AVXROctree::NodeColor = InNodeColor;
+            AVXROctree::SpawnElementActors = InSpawnElementActors;
+            AVXROctree::KeepExactSamples = InKeepExactSamples;
 
             AVXROctreeElement::DrawLifeTime = InDrawLifeTime;
 
@@ -84,6 +91,9 @@ void AVXROctree::DrawNode( const FVector& InOrigin, const FVector& InExtent )
 void AVXROctree::DrawDebugElement()
 {
     if ( IsLeafNode() ) {
+        if ( ElementList.Num() == 0 && PackedSamples.Num() > 0 )
+            DrawPackedSamples();
+
         for ( auto elem : ElementList )
             elem->DrawDebug();
     }
@@ -93,6 +103,17 @@ void AVXROctree::DrawDebugElement()
     }
 }
 
+void AVXROctree::DrawPackedSamples()
+{
+    auto world = GetWorld();
+    if ( ensure( world != nullptr ) ) {
+        auto extent = BoundingBox.Extent * 0.15f;
+        for ( int32 i = 0; i < PackedSamples.Num(); ++i ) {
+            DrawDebugBox( world, GetSamplePosition( i ), extent, AVXROctree::NodeColor, false, AVXROctreeElement::DrawLifeTime, (uint8)'\000', 1.0f );
+        }
+    }
+}
+
 FVector AVXROctree::GetBoundingBoxOrigin() const
 {
     return BoundingBox.Origin;
@@ -106,7 +127,7 @@ FVector AVXROctree::GetBoundingBoxExtent() const
 void AVXROctree::BuildOctreeWithPositions( const TArray<FVector>& InPositions )
 {
     for ( auto pos : InPositions ) {
-        VXR_LOG( Log, TEXT( "#### Instert octree. Element Position:[%s] ####" ), *(pos.ToString()) );
+        VXR_LOG( Verbose, TEXT( "#### Instert octree. Element Position:[%s] ####" ), *(pos.ToString()) );
         InsertPositionInOctree( pos );
     }
 }
@@ -117,19 +138,18 @@ bool AVXROctree::InsertPositionInOctree( const FVector& InPosition )
         if ( InsertChildrenTree( InPosition ) )
             return true;
         
-        if ( IsLeafNode() ) {
+        // Children at MaxDepth reject every insert, so only split when they can take the sample.
+        if ( IsLeafNode() && BoundingBox.Depth + 1 < AVXROctree::MaxDepth ) {
             BuildChildrenTree();
             if ( InsertChildrenTree( InPosition ) )
                 return true;
-        }
 
-        if ( ChildrenTree.Num() > 0 ) {
             for ( auto octree : ChildrenTree )
                 octree->Destroy();
             ChildrenTree.Empty();
         }
 
-        if ( ElementList.Num() < AVXROctree::MaxElements ) {
+        if ( PackedSamples.Num() < AVXROctree::MaxElements ) {
             SpawnElement( InPosition, 0.0f, 0.0f );
             return true;
         }
@@ -138,7 +158,7 @@ bool AVXROctree::InsertPositionInOctree( const FVector& InPosition )
         return false;
     }
 
-    VXR_LOG( Log, TEXT( "#### Cannot be inserted to the Octree. Octree Depth:[%d] Element Position:[%s] ####" ), 
+    VXR_LOG( Verbose, TEXT( "#### Cannot be inserted to the Octree. Octree Depth:[%d] Element Position:[%s] ####" ), 
         BoundingBox.Depth, *(InPosition.ToString()) );
     return false;
 }
@@ -157,7 +177,7 @@ bool AVXROctree::InsertChildrenTree( const FVector& InPosition )
 void AVXROctree::BuildOctreeWithCameraDatas( const TArray<FVXRCameraData>& InCameraDatas )
 {
     for ( auto& data : InCameraDatas ) {
-        VXR_LOG( Log, TEXT( "#### Insert octree. Camera Position:[%s], Offset[Yaw, Pitch]:[%f, %f] ####" ), 
+        VXR_LOG( Verbose, TEXT( "#### Insert octree. Camera Position:[%s], Offset[Yaw, Pitch]:[%f, %f] ####" ), 
             *(data.Position.ToString()), data.OffsetYaw, data.OffsetPitch );
         InsertElementInOctree( data.Position, data.OffsetYaw, data.OffsetPitch );
     }
@@ -169,19 +189,18 @@ bool AVXROctree::InsertElementInOctree( const FVector& InPosition, float InOffse
         if ( InsertChildrenTree( InPosition, InOffsetYaw, InOffsetPitch ) )
             return true;
 
-        if ( IsLeafNode() ) {
+        // Children at MaxDepth reject every insert, so only split when they can take the sample.
+        if ( IsLeafNode() && BoundingBox.Depth + 1 < AVXROctree::MaxDepth ) {
             BuildChildrenTree();
             if ( InsertChildrenTree( InPosition, InOffsetYaw, InOffsetPitch ) )
                 return true;
-        }
 
-        if ( ChildrenTree.Num() > 0 ) {
             for ( auto octree : ChildrenTree )
                 octree->Destroy();
             ChildrenTree.Empty();
         }
 
-        if ( ElementList.Num() < AVXROctree::MaxElements ) {
+        if ( PackedSamples.Num() < AVXROctree::MaxElements ) {
             SpawnElement( InPosition, InOffsetYaw, InOffsetPitch );
             return true;
         }
@@ -190,7 +209,7 @@ bool AVXROctree::InsertElementInOctree( const FVector& InPosition, float InOffse
         return false;
     }
 
-    VXR_LOG( Log, TEXT( "#### Cannot be inserted to the Octree. Octree Depth:[%d] Element Position:[%s] ####" ), 
+    VXR_LOG( Verbose, TEXT( "#### Cannot be inserted to the Octree. Octree Depth:[%d] Element Position:[%s] ####" ), 
         BoundingBox.Depth, *(InPosition.ToString()) );
     return false;
 }
@@ -208,6 +227,16 @@ bool AVXROctree::InsertChildrenTree( const FVector& InPosition, float InOffsetYa
 
 bool AVXROctree::SpawnElement( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch )
 {
+    auto sample = FVXRPackedSample::Encode( InPosition, InOffsetYaw, InOffsetPitch, BoundingBox.Origin, BoundingBox.Extent );
+    if ( !AVXROctree::SpawnElementActors ) {
+        PackedSamples.Add( sample );
+        if ( AVXROctree::KeepExactSamples )
+            AddExactSample( InPosition, InOffsetYaw, InOffsetPitch );
+        VXR_LOG( Verbose, TEXT( "#### Insert to the octree node. Depth:[%d] Position:[%s] ####" ), 
+            BoundingBox.Depth, *(InPosition.ToString()) );
+        return true;
+    }
+
     auto world = GetWorld();
     if ( ensure( world != nullptr ) ) {
         FActorSpawnParameters spawnInfo;
@@ -216,8 +245,11 @@ bool AVXROctree::SpawnElement( const FVector& InPosition, float InOffsetYaw, flo
             auto color = FColor( FMath::RandRange(0, 255), FMath::RandRange(0, 255), FMath::RandRange(0, 255) );
             newElement->Setup( InOffsetYaw, InOffsetPitch, BoundingBox.Extent, color );
             ElementList.Add( newElement );
+            PackedSamples.Add( sample );
+            if ( AVXROctree::KeepExactSamples )
+                AddExactSample( InPosition, InOffsetYaw, InOffsetPitch );
 
-            VXR_LOG( Log, TEXT( "#### Insert to the octree node. Depth:[%d] Position:[%s] ####" ), 
+            VXR_LOG( Verbose, TEXT( "#### Insert to the octree node. Depth:[%d] Position:[%s] ####" ), 
                 BoundingBox.Depth, *(InPosition.ToString()) );
             return true;
         }
@@ -226,6 +258,14 @@ bool AVXROctree::SpawnElement( const FVector& InPosition, float InOffsetYaw, flo
     return false;
 }
 
+void AVXROctree::AddExactSample( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch )
+{
+    auto& data = ExactSamples.AddDefaulted_GetRef();
+    data.Position = InPosition;
+    data.OffsetYaw = InOffsetYaw;
+    data.OffsetPitch = InOffsetPitch;
+}
+
 void AVXROctree::BuildChildrenTree()
 {
     int32 depth = BoundingBox.Depth + 1;
@@ -234,32 +274,10 @@ void AVXROctree::BuildChildrenTree()
         return;
     }
 
-    VXR_LOG( Log, TEXT( "#### Build children octree. ####" ) );
+    VXR_LOG( Verbose, TEXT( "#### Build children octree. ####" ) );
     auto halfDimension = BoundingBox.Extent * 0.5f;
-    auto center = halfDimension;
-
-    FVector nodeOrigins[8];
-
-    // Top Left Back: -X, -Y, +Z
-    nodeOrigins[0] = FVector( BoundingBox.Origin.X - center.X, BoundingBox.Origin.Y - center.Y, BoundingBox.Origin.Z + center.Z );
-    // Top Right Back: +X, -Y, +Z
-    nodeOrigins[1] = FVector( BoundingBox.Origin.X + center.X, BoundingBox.Origin.Y - center.Y, BoundingBox.Origin.Z + center.Z );
-    // Top Left Front: -X, +Y, +Z
-    nodeOrigins[2] = FVector( BoundingBox.Origin.X - center.X, BoundingBox.Origin.Y + center.Y, BoundingBox.Origin.Z + center.Z );
-    // Top Right Front: +X, +Y, +Z
-    nodeOrigins[3] = FVector( BoundingBox.Origin.X + center.X, BoundingBox.Origin.Y + center.Y, BoundingBox.Origin.Z + center.Z );
-
-    // Bottom Left Back: -X, _y, -Z
-    nodeOrigins[4] = FVector( BoundingBox.Origin.X - center.X, BoundingBox.Origin.Y - center.Y, BoundingBox.Origin.Z - center.Z );
-    // Bottom Right Back: +X, -Y, -Z
-    nodeOrigins[5] = FVector( BoundingBox.Origin.X + center.X, BoundingBox.Origin.Y - center.Y, BoundingBox.Origin.Z - center.Z );
-    // Bottom Left Front: -X, +Y, -Z
-    nodeOrigins[6] = FVector( BoundingBox.Origin.X - center.X, BoundingBox.Origin.Y + center.Y, BoundingBox.Origin.Z - center.Z );
-    // Bottom Right Front: +X, +Y, -Z
-    nodeOrigins[7] = FVector( BoundingBox.Origin.X + center.X, BoundingBox.Origin.Y + center.Y, BoundingBox.Origin.Z - center.Z );
-
-    for ( auto origin : nodeOrigins ) {
-        if ( !SpawnOctree( origin, halfDimension, depth ) )
+    for ( int32 octant = 0; octant < 8; ++octant ) {
+        if ( !SpawnOctree( VXROctreeOctant::GetChildOrigin( BoundingBox.Origin, halfDimension, octant ), halfDimension, depth ) )
             return;
     }
 }
@@ -346,6 +364,199 @@ AVXROctreeElement* AVXROctree::FindElementFromChildrenTree( const FVector& InPos
     return nullptr;
 }
 
+const AVXROctree* AVXROctree::FindSampleLeaf( const FVector& InPosition ) const
+{
+    if ( IsInNodeRange( InPosition ) ) {
+        for ( auto child : ChildrenTree ) {
+            auto found = child->FindSampleLeaf( InPosition );
+            if ( found != nullptr )
+                return found;
+        }
+
+        if ( PackedSamples.Num() > 0 )
+            return this;
+    }
+
+    return nullptr;
+}
+
+int32 AVXROctree::FindNearestSamples( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const
+{
+    auto leaf = FindSampleLeaf( InPosition );
+    if ( leaf == nullptr || InCount <= 0 )
+        return 0;
+
+    IVXRSpatialIndex::TNearestList<int32> best;
+    for ( int32 i = 0; i < leaf->PackedSamples.Num(); ++i )
+        IVXRSpatialIndex::AddNearestCandidate( best, InCount, FVector::DistSquared( InPosition, leaf->GetSamplePosition( i ) ), i );
+
+    for ( int32 i = 0; i < best.Num(); ++i )
+        OutCameraDatas[i] = leaf->GetSample( best[i].Value );
+
+    return best.Num();
+}
+
+void AVXROctree::QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    auto nodeBox = GetNodeBox();
+    if ( !InBox.Intersect( nodeBox ) )
+        return;
+
+    if ( InBox.IsInsideOrOn( nodeBox.Min ) && InBox.IsInsideOrOn( nodeBox.Max ) ) {
+        GetCameraDatas( OutCameraDatas );
+        return;
+    }
+
+    for ( int32 i = 0; i < PackedSamples.Num(); ++i ) {
+        auto data = GetSample( i );
+        if ( InBox.IsInsideOrOn( data.Position ) )
+            OutCameraDatas.Add( data );
+    }
+
+    for ( auto child : ChildrenTree )
+        child->QueryBox( InBox, OutCameraDatas );
+}
+
+void AVXROctree::QuerySphere( const FVector& InCenter, float InRadius, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( InRadius >= 0.0f )
+        QuerySphereSquared( InCenter, FMath::Square( InRadius ), OutCameraDatas );
+}
+
+void AVXROctree::QuerySphereSquared( const FVector& InCenter, float InRadiusSq, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    auto nodeBox = GetNodeBox();
+    if ( !FMath::SphereAABBIntersection( InCenter, InRadiusSq, nodeBox ) )
+        return;
+
+    // The node lies inside the sphere when its farthest corner does.
+    auto farthest = FVector( FMath::Max( FMath::Abs( InCenter.X - nodeBox.Min.X ), FMath::Abs( nodeBox.Max.X - InCenter.X ) ),
+        FMath::Max( FMath::Abs( InCenter.Y - nodeBox.Min.Y ), FMath::Abs( nodeBox.Max.Y - InCenter.Y ) ),
+        FMath::Max( FMath::Abs( InCenter.Z - nodeBox.Min.Z ), FMath::Abs( nodeBox.Max.Z - InCenter.Z ) ) );
+    if ( farthest.SizeSquared() <= InRadiusSq ) {
+        GetCameraDatas( OutCameraDatas );
+        return;
+    }
+
+    for ( int32 i = 0; i < PackedSamples.Num(); ++i ) {
+        auto data = GetSample( i );
+        if ( FVector::DistSquared( InCenter, data.Position ) <= InRadiusSq )
+            OutCameraDatas.Add( data );
+    }
+
+    for ( auto child : ChildrenTree )
+        child->QuerySphereSquared( InCenter, InRadiusSq, OutCameraDatas );
+}
+
+void AVXROctree::QueryFrustum( const FConvexVolume& InFrustum, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    bool fullyContained = false;
+    if ( !InFrustum.IntersectBox( BoundingBox.Origin, BoundingBox.Extent.GetAbs(), fullyContained ) )
+        return;
+
+    if ( fullyContained ) {
+        GetCameraDatas( OutCameraDatas );
+        return;
+    }
+
+    for ( int32 i = 0; i < PackedSamples.Num(); ++i ) {
+        auto data = GetSample( i );
+        if ( InFrustum.IntersectSphere( data.Position, 0.0f ) )
+            OutCameraDatas.Add( data );
+    }
+
+    for ( auto child : ChildrenTree )
+        child->QueryFrustum( InFrustum, OutCameraDatas );
+}
+
+bool AVXROctree::RemoveElementInOctree( const FVector& InPosition, float InTolerance )
+{
+    AVXROctree* node = nullptr;
+    int32 index = INDEX_NONE;
+    float distSq = FMath::Square( InTolerance );
+    FindClosestSample( InPosition, distSq, node, index );
+    if ( node == nullptr ) {
+        VXR_LOG( Log, TEXT( "#### Cannot find element to remove. Position:[%s] Tolerance:[%f] ####" ), 
+            *(InPosition.ToString()), InTolerance );
+        return false;
+    }
+
+    node->RemoveSampleAt( index );
+    return true;
+}
+
+void AVXROctree::FindClosestSample( const FVector& InPosition, float& InOutDistSq, AVXROctree*& OutNode, int32& OutIndex )
+{
+    if ( !FMath::SphereAABBIntersection( InPosition, InOutDistSq, GetNodeBox() ) )
+        return;
+
+    for ( int32 i = 0; i < PackedSamples.Num(); ++i ) {
+        auto distSq = FVector::DistSquared( InPosition, GetSamplePosition( i ) );
+        if ( distSq <= InOutDistSq ) {
+            InOutDistSq = distSq;
+            OutNode = this;
+            OutIndex = i;
+        }
+    }
+
+    for ( auto child : ChildrenTree )
+        child->FindClosestSample( InPosition, InOutDistSq, OutNode, OutIndex );
+}
+
+void AVXROctree::RemoveSampleAt( int32 InIndex )
+{
+    PackedSamples.RemoveAt( InIndex );
+    if ( ExactSamples.IsValidIndex( InIndex ) )
+        ExactSamples.RemoveAt( InIndex );
+    if ( ElementList.IsValidIndex( InIndex ) ) {
+        if ( ElementList[InIndex] != nullptr )
+            ElementList[InIndex]->Destroy();
+        ElementList.RemoveAt( InIndex );
+    }
+}
+
+FVector AVXROctree::GetSamplePosition( int32 InIndex ) const
+{
+    if ( ExactSamples.IsValidIndex( InIndex ) )
+        return ExactSamples[InIndex].Position;
+
+    return PackedSamples[InIndex].DecodePosition( BoundingBox.Origin, BoundingBox.Extent );
+}
+
+FVXRCameraData AVXROctree::GetSample( int32 InIndex ) const
+{
+    if ( ExactSamples.IsValidIndex( InIndex ) )
+        return ExactSamples[InIndex];
+
+    return PackedSamples[InIndex].Decode( BoundingBox.Origin, BoundingBox.Extent );
+}
+
+int32 AVXROctree::GetElementCount() const
+{
+    auto count = PackedSamples.Num();
+    for ( auto child : ChildrenTree )
+        count += child->GetElementCount();
+
+    return count;
+}
+
+void AVXROctree::DestroyOctree()
+{
+    for ( auto child : ChildrenTree )
+        child->DestroyOctree();
+    ChildrenTree.Empty();
+
+    for ( auto elem : ElementList ) {
+        if ( elem != nullptr )
+            elem->Destroy();
+    }
+    ElementList.Empty();
+    PackedSamples.Empty();
+    ExactSamples.Empty();
+
+    Destroy();
+}
+
 AVXROctree* AVXROctree::FindNode( const FVector& InPosition )
 {
     if ( IsInNodeRange( InPosition ) ) {
@@ -373,7 +584,7 @@ AVXROctree* AVXROctree::FindNodeFromChildrenTree( const FVector& InPosition )
     return nullptr;
 }
 
-bool AVXROctree::IsInNodeRange( const FVector& InObjectPos )
+bool AVXROctree::IsInNodeRange( const FVector& InObjectPos ) const
 {
     auto minX = FMath::Min( BoundingBox.Origin.X - BoundingBox.Extent.X, BoundingBox.Origin.X + BoundingBox.Extent.X );
     auto maxX = FMath::Max( BoundingBox.Origin.X - BoundingBox.Extent.X, BoundingBox.Origin.X + BoundingBox.Extent.X );
@@ -393,6 +604,11 @@ bool AVXROctree::IsInNodeRange( const FVector& InObjectPos )
     return false;
 }
 
+FBox AVXROctree::GetNodeBox() const
+{
+    return FBox::BuildAABB( BoundingBox.Origin, BoundingBox.Extent.GetAbs() );
+}
+
 bool AVXROctree::IsLeafNode() const
 {
     return ChildrenTree.Num() == 0;
@@ -407,6 +623,38 @@ void AVXROctree::GetElementDatas( TArray<FString>& OutElementDatas )
         return;
     }
 
+    if ( IsLeafNode() && PackedSamples.Num() > 0 ) {
+        for ( int32 i = 0; i < PackedSamples.Num(); ++i ) {
+            auto data = GetSample( i );
+            OutElementDatas.Add( FString::Printf( TEXT( "OctreeElement[Position, Yaw, Pitch]:%f,%f,%f,%f,%f" ), 
+                data.Position.X, data.Position.Y, data.Position.Z, data.OffsetYaw, data.OffsetPitch ) );
+        }
+
+        return;
+    }
+
     for ( auto child : ChildrenTree )
         child->GetElementDatas( OutElementDatas );
 }
+
+void AVXROctree::GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    for ( int32 i = 0; i < PackedSamples.Num(); ++i )
+        OutCameraDatas.Add( GetSample( i ) );
+
+    for ( auto child : ChildrenTree )
+        child->GetCameraDatas( OutCameraDatas );
+}
+
+void AVXROctree::GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const
+{
+    if ( PackedSamples.Num() > 0 ) {
+        auto& block = OutBlocks.AddDefaulted_GetRef();
+        block.Origin = BoundingBox.Origin;
+        block.Extent = BoundingBox.Extent;
+        block.Samples = PackedSamples;
+    }
+
+    for ( auto child : ChildrenTree )
+        child->GetPackedSampleBlocks( OutBlocks );
+}
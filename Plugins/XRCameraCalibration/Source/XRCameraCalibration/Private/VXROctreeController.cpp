@@ -1,8 +1,69 @@
 #include "VXROctreeController.h"
 #include "VXROctree.h"
 #include "VXROctreeElement.h"
+#include "VXROctreeSpatialIndex.h"
+#include "VXRHashGridSpatialIndex.h"
+#include "VXRVersionedOctreeSpatialIndex.h"
+#include "VXRCompactOctreeSpatialIndex.h"
+#include "VXRCalibrationDataAsset.h"
+#include "VXRCalibrationInterpolation.h"
 #include "VXRLog.h"
 #include "DrawDebugHelpers.h"
+#include "Async/Async.h"
+#if VXR_WITH_HOT_RELOAD
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+#endif
+
+namespace
+{
+    bool LoadElementDataFile( const FString& InFilePath, EVXRElementDataFormat InFormat, FVXRCalibrationTextCodec& InTextCodec, 
+        TArray<FVXRCameraData>& OutCameraDatas, int32& OutMalformedLineCount )
+    {
+        if ( InFormat == EVXRElementDataFormat::Packed ) {
+            TArray<FVXRPackedSampleBlock> blocks;
+            if ( !VXRPackedSampleFile::Load( InFilePath, blocks ) )
+                return false;
+
+            for ( auto& block : blocks ) {
+                for ( auto& sample : block.Samples )
+                    OutCameraDatas.Add( sample.Decode( block.Origin, block.Extent ) );
+            }
+            return true;
+        }
+
+        FVXRTextParseReport report;
+        if ( !InTextCodec.LoadFile( InFilePath, OutCameraDatas, report ) )
+            return false;
+
+        OutMalformedLineCount = report.MalformedLineCount;
+        return true;
+    }
+
+    // True while the index still holds InSample unchanged, i.e. it was not edited since the reload snapshot.
+    bool ContainsSample( const IVXRSpatialIndex& InIndex, const FVXRCameraData& InSample, TArray<FVXRCameraData>& InScratch )
+    {
+        InScratch.Reset();
+        InIndex.QueryBox( FBox::BuildAABB( InSample.Position, FVector( KINDA_SMALL_NUMBER ) ), InScratch );
+        return InScratch.ContainsByPredicate( [&InSample]( const FVXRCameraData& InData ){
+                return InData.Position.Equals( InSample.Position, KINDA_SMALL_NUMBER ) && 
+                    FMath::IsNearlyEqual( InData.OffsetYaw, InSample.OffsetYaw ) && FMath::IsNearlyEqual( InData.OffsetPitch, InSample.OffsetPitch );
+            } );
+    }
+
+    // True if any sample shares the position key of InPosition. The whole key cell is queried, because a nearest
+    // lookup is leaf-local on the actor octree.
+    bool ContainsPositionKey( const IVXRSpatialIndex& InIndex, const FVector& InPosition, float InKeyResolution, TArray<FVXRCameraData>& InScratch )
+    {
+        auto resolution = FMath::Max( InKeyResolution, KINDA_SMALL_NUMBER );
+        auto key = VXRElementDataDiff::GetPositionKey( InPosition, resolution );
+        InScratch.Reset();
+        InIndex.QueryBox( FBox::BuildAABB( FVector( key ) * resolution, FVector( 0.5f * resolution ) ), InScratch );
+        return InScratch.ContainsByPredicate( [&key, resolution]( const FVXRCameraData& InData ){
+                return VXRElementDataDiff::GetPositionKey( InData.Position, resolution ) == key;
+            } );
+    }
+}
 
 AVXROctreeController::AVXROctreeController( const FObjectInitializer& ObjectInitializer )
     : Super( ObjectInitializer )
@@ -10,16 +71,60 @@ AVXROctreeController::AVXROctreeController( const FObjectInitializer& ObjectInit
     PrimaryActorTick.bCanEverTick = true;
     RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
 
+    SpatialIndexType = EVXRSpatialIndexType::Octree;
+    GridCellSize = 100.0f;
+    CompactOctreeMaxDepth = 8;
+    VersionedOctreeMaxDepth = 8;
     MaxDepth = 1;
     MaxElements = 2;
+    SpawnElementActors = false;
     UseDebugDraw = false;
     DebugDrawLifeTime = 0.1f;
+    PublishSharedMemory = false;
+    SharedMemoryName = TEXT( "VXRCalibration" );
+    SharedMemoryCapacity = 65536;
+    CalibrationAsset = nullptr;
+    LastMalformedLineCount = 0;
+    IndexRevision = 0;
+    VersionedIndex = nullptr;
+    PublishPending = false;
+    HotReloadElementData = false;
+    HotReloadBatchSize = 64;
+    HotReloadKeyResolution = 1.0f;
+    ConcurrentInsertBatchSize = 64;
+    ConcurrentInsertCapacity = 4096;
+    PendingChangeIndex = 0;
+    ReloadInProgress = false;
+    ReloadRequested = false;
+    AcceptConcurrentInserts = false;
+    AnalysisCellSize = 50.0f;
+    AnalysisSuggestionCount = 8;
+    AnalysisErrorScale = 1.0f;
+    AnalysisInProgress = false;
 }
 
 void AVXROctreeController::BeginPlay()
 {
-    RootOctree = AVXROctree::SpawnRootOctree( GetWorld(), GetActorLocation(), Extent, ElementClass, 
-        MaxElements, MaxDepth, DebugDrawLifeTime, NodeColor );
+    CreateSpatialIndex();
+    LoadCalibrationAsset();
+
+    ConcurrentInserts.SetCapacity( ConcurrentInsertCapacity );
+    AcceptConcurrentInserts = true;
+
+    if ( PublishSharedMemory && Publisher.Open( SharedMemoryName, SharedMemoryCapacity ) )
+        PublishPending = true;
+
+#if VXR_WITH_HOT_RELOAD
+    if ( HotReloadElementData && !ElementDataPath.Path.IsEmpty() && !ElementDataFilename.IsEmpty() ) {
+        auto& directoryWatcher = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>( TEXT( "DirectoryWatcher" ) );
+        if ( directoryWatcher.Get() != nullptr ) {
+            WatchedDirectory = FPaths::ConvertRelativePathToFull( ElementDataPath.Path );
+            directoryWatcher.Get()->RegisterDirectoryChangedCallback_Handle( WatchedDirectory, 
+                IDirectoryWatcher::FDirectoryChanged::CreateUObject( this, &AVXROctreeController::OnElementDataDirectoryChanged ), 
+                ElementDataWatchHandle );
+        }
+    }
+#endif
 
     if ( !DebugDrawHandle.IsValid() && RootOctree != nullptr ) {
         TWeakObjectPtr<AVXROctreeController> weakThis( this );
@@ -39,81 +144,314 @@ void AVXROctreeController::EndPlay( EEndPlayReason::Type InEndPlayReason )
     if ( DebugDrawHandle.IsValid() )
         GetWorldTimerManager().ClearTimer( DebugDrawHandle );
 
+    AcceptConcurrentInserts = false;
+    auto droppedInserts = ConcurrentInserts.Reset();
+    VXR_CLOG( droppedInserts > 0, Warning, TEXT( "#### Queued samples discarded at end play. Controller:[%s] Samples:[%d] ####" ),
+        *GetName(), droppedInserts );
+
+#if VXR_WITH_HOT_RELOAD
+    if ( ElementDataWatchHandle.IsValid() ) {
+        auto directoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>( TEXT( "DirectoryWatcher" ) );
+        if ( directoryWatcherModule != nullptr && directoryWatcherModule->Get() != nullptr )
+            directoryWatcherModule->Get()->UnregisterDirectoryChangedCallback_Handle( WatchedDirectory, ElementDataWatchHandle );
+        ElementDataWatchHandle.Reset();
+    }
+#endif
+    PendingChanges.Reset();
+    PendingChangeIndex = 0;
+    ReloadRequested = false;
+
+    Publisher.Close();
+    PublishedKdTree.Reset();
+    VersionedIndex = nullptr;
+    SpatialIndex.Reset();
+
     Super::EndPlay( InEndPlayReason );
 }
 
-FRotator AVXROctreeController::GetCollectCameraRotationFromRootOctree( const FVector& InCameraPosition )
+void AVXROctreeController::CreateSpatialIndex()
 {
-    auto found = FindOctreeNode( InCameraPosition );
-    return GetCollectCameraRotationFromOctree( InCameraPosition, found ? CurrentOctree : RootOctree );
+    VersionedIndex = nullptr;
+    switch ( SpatialIndexType ) {
+        case EVXRSpatialIndexType::HashGrid:
+            RootOctree = nullptr;
+            SpatialIndex = MakeUnique<FVXRFreezableSpatialIndex>( MakeUnique<FVXRHashGridSpatialIndex>( GridCellSize ) );
+            break;
+
+        case EVXRSpatialIndexType::VersionedOctree: {
+            RootOctree = nullptr;
+            auto versionedIndex = MakeUnique<FVXRVersionedOctreeSpatialIndex>( GetActorLocation(), Extent, MaxElements, VersionedOctreeMaxDepth );
+            VersionedIndex = versionedIndex.Get();
+            SpatialIndex = MakeUnique<FVXRFreezableSpatialIndex>( MoveTemp( versionedIndex ) );
+            break;
+        }
+
+        case EVXRSpatialIndexType::CompactOctree:
+            RootOctree = nullptr;
+            SpatialIndex = MakeUnique<FVXRFreezableSpatialIndex>( MakeUnique<FVXRCompactOctreeSpatialIndex>( GetActorLocation(), Extent, CompactOctreeMaxDepth ) );
+            break;
+
+        default:
+            // The legacy text file stores full precision samples, so the leaves keep them next to the packed copy.
+            RootOctree = AVXROctree::SpawnRootOctree( GetWorld(), GetActorLocation(), Extent, ElementClass, 
+                MaxElements, MaxDepth, DebugDrawLifeTime, NodeColor, SpawnElementActors, ElementDataFormat == EVXRElementDataFormat::Text );
+            SpatialIndex = MakeUnique<FVXRFreezableSpatialIndex>( MakeUnique<FVXROctreeSpatialIndex>( RootOctree ) );
+            break;
+    }
+
+    VXR_LOG( Log, TEXT( "#### Create spatial index. Type:[%s] ####" ), SpatialIndex->GetName() );
 }
 
-FRotator AVXROctreeController::GetCollectCameraRotationFromOctree( const FVector& InCameraPosition, AVXROctree* InOctreeNode )
+void AVXROctreeController::LoadCalibrationAsset()
 {
-    if ( ensure( InOctreeNode != nullptr ) ) {
-        AVXROctreeElement* elems[2] = { nullptr, nullptr };
-        elems[0] = InOctreeNode->FindElement( InCameraPosition, nullptr );
-
-        if ( elems[0] != nullptr ) {
-            elems[1] = InOctreeNode->FindElement( InCameraPosition, elems[0] );
-
-            if ( elems[1] != nullptr ) {
-                //VXR_LOG( Warning, TEXT( "#### Camera position:[%s] ####" ), *(InCameraPosition.ToString()) );
-                //VXR_LOG( Warning, TEXT( "#### Collect find first. Name:[%s] Data:[%s] ####" ), *(elems[0]->GetName()), *(elems[0]->DataToString()) );
-                //VXR_LOG( Warning, TEXT( "#### Collect find second. Name:[%s] Data:[%s] ####" ), *(elems[1]->GetName()), *(elems[1]->DataToString()) );
-                FRotator offsetRot;
-                offsetRot.Yaw = GetCollectCameraRotatorComponent( InCameraPosition, elems[0]->GetOffsetYaw(), elems[1]->GetOffsetYaw(), 
-                    elems[0]->GetActorLocation(), elems[1]->GetActorLocation(), FColor::Red );
-                offsetRot.Pitch = GetCollectCameraRotatorComponent( InCameraPosition, elems[0]->GetOffsetPitch(), elems[1]->GetOffsetPitch(), 
-                    elems[0]->GetActorLocation(), elems[1]->GetActorLocation(), FColor::Blue );
-
-                return offsetRot;
-            }
-        }
+    if ( CalibrationAsset == nullptr || !SpatialIndex.IsValid() )
+        return;
+
+    FVXRStaticKdTree kdTree;
+    if ( CalibrationAsset->CreateKdTree( kdTree ) ) {
+        SpatialIndex->Freeze( MoveTemp( kdTree ) );
+        MarkIndexChanged();
     }
+}
 
-    return FRotator::ZeroRotator;
+IVXRSpatialIndex* AVXROctreeController::GetSpatialIndex() const
+{
+    return SpatialIndex.Get();
 }
 
-float AVXROctreeController::GetCollectCameraRotatorComponent( const FVector& InCameraPosition, float InRotComp0, float InRotComp1, 
-    const FVector& InElementPos0, const FVector& InElementPos1, const FColor& InColor )
+void AVXROctreeController::MarkIndexChanged()
+{
+    ++IndexRevision;
+    PublishPending = Publisher.IsOpen();
+}
+
+void AVXROctreeController::Tick( float DeltaSeconds )
+{
+    Super::Tick( DeltaSeconds );
+
+#if VXR_WITH_HOT_RELOAD
+    // Only the editor engine ticks the directory watcher; a game build has to do it to get callbacks.
+    if ( ElementDataWatchHandle.IsValid() && !GIsEditor ) {
+        auto directoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>( TEXT( "DirectoryWatcher" ) );
+        if ( directoryWatcherModule != nullptr && directoryWatcherModule->Get() != nullptr )
+            directoryWatcherModule->Get()->Tick( DeltaSeconds );
+    }
+#endif
+
+    DrainConcurrentInserts();
+    ApplyElementDataChanges();
+
+    // Edits only mark the table dirty, so a burst of inserts is published once per frame.
+    if ( PublishPending ) {
+        PublishPending = false;
+        PublishSharedMemoryTable();
+    }
+}
+
+bool AVXROctreeController::InsertToOctreeThreadSafe( const FVXRCameraData& InCameraData )
+{
+    if ( !AcceptConcurrentInserts )
+        return false;
+
+    return ConcurrentInserts.Enqueue( InCameraData );
+}
+
+void AVXROctreeController::DrainConcurrentInserts()
+{
+    if ( !SpatialIndex.IsValid() || ConcurrentInserts.GetPendingCount() == 0 )
+        return;
+
+    // One undo step per frame on the versioned backend.
+    if ( VersionedIndex != nullptr )
+        VersionedIndex->BeginEditGroup();
+
+    // Capped like hot reload batches, so a burst of samples does not spawn thousands of actors in one frame.
+    int32 rejectedCount = 0;
+    auto inserted = ConcurrentInserts.Drain( *SpatialIndex, FMath::Max( ConcurrentInsertBatchSize, 1 ), rejectedCount );
+
+    if ( VersionedIndex != nullptr )
+        VersionedIndex->EndEditGroup();
+
+    if ( inserted > 0 )
+        MarkIndexChanged();
+    VXR_CLOG( rejectedCount > 0, Warning, TEXT( "#### Queued samples rejected by the spatial index. Index:[%s] Rejected:[%d] ####" ),
+        SpatialIndex->GetName(), rejectedCount );
+}
+
+void AVXROctreeController::PublishSharedMemoryTable()
+{
+    if ( !SpatialIndex.IsValid() || !Publisher.IsOpen() )
+        return;
+
+    auto capacity = Publisher.GetSampleCapacity();
+    if ( IsIndexFrozen() && SpatialIndex->GetFrozenIndex().Num() <= capacity ) {
+        Publisher.Publish( SpatialIndex->GetFrozenIndex(), false );
+        return;
+    }
+
+    PublishScratch.Reset();
+    SpatialIndex->GetCameraDatas( PublishScratch );
+
+    auto truncated = PublishScratch.Num() > capacity;
+    if ( truncated ) {
+        // Keep an even spread over the table instead of its first entries.
+        auto sampleCount = PublishScratch.Num();
+        for ( int32 i = 0; i < capacity; ++i )
+            PublishScratch[i] = PublishScratch[(int64)i * sampleCount / capacity];
+        PublishScratch.SetNum( capacity, false );
+
+        VXR_LOG( Verbose, TEXT( "#### Shared memory table truncated. Samples:[%d] Capacity:[%d] ####" ), sampleCount, capacity );
+    }
+
+    PublishedKdTree.Build( PublishScratch );
+    Publisher.Publish( PublishedKdTree, truncated );
+}
+
+uint32 AVXROctreeController::GetIndexRevision() const
+{
+    return IndexRevision;
+}
+
+void AVXROctreeController::FreezeIndex()
+{
+    MarkIndexChanged();
+    if ( SpatialIndex.IsValid() )
+        SpatialIndex->Freeze();
+}
+
+bool AVXROctreeController::ThawIndex()
+{
+    MarkIndexChanged();
+    return SpatialIndex.IsValid() && SpatialIndex->Thaw();
+}
+
+bool AVXROctreeController::IsIndexFrozen() const
+{
+    return SpatialIndex.IsValid() && SpatialIndex->IsFrozen();
+}
+
+bool AVXROctreeController::Undo()
+{
+    if ( VersionedIndex == nullptr || !VersionedIndex->CanUndo() )
+        return false;
+
+    if ( !ThawIndex() )
+        return false;
+
+    return VersionedIndex->Undo();
+}
+
+bool AVXROctreeController::Redo()
+{
+    if ( VersionedIndex == nullptr || !VersionedIndex->CanRedo() )
+        return false;
+
+    if ( !ThawIndex() )
+        return false;
+
+    return VersionedIndex->Redo();
+}
+
+bool AVXROctreeController::SaveCalibrationVersion( FName InVersionName )
+{
+    if ( VersionedIndex == nullptr || InVersionName.IsNone() )
+        return false;
+
+    VersionedIndex->SaveVersion( InVersionName );
+    return true;
+}
+
+bool AVXROctreeController::SwitchCalibrationVersion( FName InVersionName )
+{
+    if ( VersionedIndex == nullptr )
+        return false;
+
+    if ( !ThawIndex() )
+        return false;
+
+    return VersionedIndex->SwitchVersion( InVersionName );
+}
+
+void AVXROctreeController::GetCalibrationVersionNames( TArray<FName>& OutVersionNames ) const
 {
-    FVector minPos, maxPos;
-    float minValue, maxValue;
+    OutVersionNames.Reset();
+    if ( VersionedIndex != nullptr )
+        VersionedIndex->GetVersionNames( OutVersionNames );
+}
 
-    if ( InRotComp0 < InRotComp1 ) {
-        minValue = InRotComp0;
-        maxValue = InRotComp1;
+FRotator AVXROctreeController::GetCollectCameraRotationFromRootOctree( const FVector& InCameraPosition )
+{
+    if ( RootOctree == nullptr || IsIndexFrozen() ) {
+        FVXRCameraData samples[2];
+        if ( SpatialIndex.IsValid() && SpatialIndex->FindNearest( InCameraPosition, samples, 2 ) == 2 )
+            return InterpolateCameraRotation( InCameraPosition, samples[0], samples[1] );
 
-        minPos = InElementPos0;
-        maxPos = InElementPos1;
+        return FRotator::ZeroRotator;
     }
-    else {
-        minValue = InRotComp1;
-        maxValue = InRotComp0;
 
-        minPos = InElementPos1;
-        maxPos = InElementPos0;
+    auto found = FindOctreeNode( InCameraPosition );
+    return GetCollectCameraRotationFromOctree( InCameraPosition, found ? CurrentOctree : RootOctree );
+}
+
+FRotator AVXROctreeController::GetCollectCameraRotation( const FVector& InCameraPosition, FVXRQueryCache& InOutCache ) const
+{
+    if ( InOutCache.Valid && InOutCache.IndexRevision == IndexRevision && InOutCache.Position.Equals( InCameraPosition, KINDA_SMALL_NUMBER ) )
+        return InOutCache.Result;
+
+    if ( InOutCache.IndexRevision != IndexRevision )
+        InOutCache.Node = nullptr;
+
+    FVXRCameraData samples[2];
+    int32 found = 0;
+    if ( RootOctree != nullptr && !IsIndexFrozen() ) {
+        if ( InOutCache.Node == nullptr || !InOutCache.Node->IsInNodeRange( InCameraPosition ) )
+            InOutCache.Node = RootOctree->FindNode( InCameraPosition );
+
+        auto node = InOutCache.Node != nullptr ? InOutCache.Node : RootOctree;
+        found = node->FindNearestSamples( InCameraPosition, samples, 2 );
+    }
+    else if ( SpatialIndex.IsValid() ) {
+        found = SpatialIndex->FindNearest( InCameraPosition, samples, 2 );
     }
 
-    auto direction = maxPos - minPos;
-    auto dirCamera = InCameraPosition - minPos;
-    auto projection = dirCamera.ProjectOnToNormal( direction.GetSafeNormal() );
-    auto dirSize = direction.Size();
-    auto projSize = projection.Size();
+    InOutCache.Position = InCameraPosition;
+    InOutCache.Result = found == 2 ? InterpolateCameraRotation( InCameraPosition, samples[0], samples[1] ) : FRotator::ZeroRotator;
+    InOutCache.IndexRevision = IndexRevision;
+    InOutCache.Valid = true;
 
-    //DrawDebugLine( GetWorld(), minPos, minPos + dirCamera, FColor::Green, true );
-    //DrawDebugLine( GetWorld(), minPos, minPos + projection, InColor, true );
+    return InOutCache.Result;
+}
 
-    if ( ensure( dirSize >= projSize ) ) {
-        auto alpha = projSize / dirSize;
-        //VXR_LOG( Warning, TEXT( "#### Project size:[%f] ####" ), projSize );
-        //VXR_LOG( Warning, TEXT( "#### Direction size:[%f] ####" ), dirSize );
-        //VXR_LOG( Warning, TEXT( "#### Lerp alpha:[%f] ####" ), alpha );
-        return FMath::Lerp( minValue, maxValue, alpha );
+FRotator AVXROctreeController::GetCollectCameraRotationFromOctree( const FVector& InCameraPosition, AVXROctree* InOctreeNode )
+{
+    if ( ensure( InOctreeNode != nullptr ) ) {
+        FVXRCameraData samples[2];
+        if ( InOctreeNode->FindNearestSamples( InCameraPosition, samples, 2 ) == 2 )
+            return InterpolateCameraRotation( InCameraPosition, samples[0], samples[1] );
     }
 
-    return 0.0f;
+    return FRotator::ZeroRotator;
+}
+
+FRotator AVXROctreeController::InterpolateCameraRotation( const FVector& InCameraPosition, const FVXRCameraData& InFirst, 
+    const FVXRCameraData& InSecond )
+{
+    FRotator offsetRot;
+    offsetRot.Yaw = GetCollectCameraRotatorComponent( InCameraPosition, InFirst.OffsetYaw, InSecond.OffsetYaw, 
+        InFirst.Position, InSecond.Position, FColor::Red );
+    offsetRot.Pitch = GetCollectCameraRotatorComponent( InCameraPosition, InFirst.OffsetPitch, InSecond.OffsetPitch, 
+        InFirst.Position, InSecond.Position, FColor::Blue );
+    offsetRot.Roll = 0.0f;
+
+    return offsetRot;
+}
+
+float AVXROctreeController::GetCollectCameraRotatorComponent( const FVector& InCameraPosition, float InRotComp0, float InRotComp1, 
+    const FVector& InElementPos0, const FVector& InElementPos1, const FColor& InColor )
+{
+    float value;
+    ensure( VXRCalibrationInterpolation::InterpolateRotatorComponent( InCameraPosition, InRotComp0, InRotComp1, InElementPos0, InElementPos1, value ) );
+    return value;
 }
 
 bool AVXROctreeController::InsertToOctree( const FVector& InCameraPosition )
@@ -133,8 +471,26 @@ bool AVXROctreeController::InsertToOctree( const FVector& InCameraPosition )
     return false;
 }
 
+bool AVXROctreeController::RemoveFromOctree( const FVector& InCameraPosition, float InTolerance )
+{
+    MarkIndexChanged();
+    if ( SpatialIndex.IsValid() )
+        return SpatialIndex->Remove( InCameraPosition, InTolerance );
+
+    return false;
+}
+
 bool AVXROctreeController::InsertPositionInOctree( const FVector& InCameraPosition )
 {
+    MarkIndexChanged();
+    if ( (RootOctree == nullptr || IsIndexFrozen()) && SpatialIndex.IsValid() ) {
+        FVXRCameraData camData;
+        camData.Position = InCameraPosition;
+        camData.OffsetYaw = 0.0f;
+        camData.OffsetPitch = 0.0f;
+        return SpatialIndex->Insert( camData );
+    }
+
     if ( FindOctreeNode( InCameraPosition ) )
         return CurrentOctree->InsertPositionInOctree( InCameraPosition );
 
@@ -146,6 +502,15 @@ bool AVXROctreeController::InsertPositionInOctree( const FVector& InCameraPositi
 
 bool AVXROctreeController::InsertElementInOctree( const FVector& InCameraPosition, float InOffsetYaw, float InOffsetPitch )
 {
+    MarkIndexChanged();
+    if ( (RootOctree == nullptr || IsIndexFrozen()) && SpatialIndex.IsValid() ) {
+        FVXRCameraData camData;
+        camData.Position = InCameraPosition;
+        camData.OffsetYaw = InOffsetYaw;
+        camData.OffsetPitch = InOffsetPitch;
+        return SpatialIndex->Insert( camData );
+    }
+
     if ( FindOctreeNode( InCameraPosition ) )
         return CurrentOctree->InsertElementInOctree( InCameraPosition, InOffsetYaw, InOffsetPitch );
 
@@ -171,25 +536,36 @@ bool AVXROctreeController::FindOctreeNode( const FVector& InCameraPosition )
     return false;
 }
 
+FString AVXROctreeController::GetElementDataFilePath() const
+{
+    auto extension = ElementDataFormat == EVXRElementDataFormat::Packed ? TEXT( "vxrc" ) : TEXT( "txt" );
+    auto filename = FString::Printf( TEXT( "%s.%s" ), *ElementDataFilename, extension );
+    return FPaths::Combine( ElementDataPath.Path, filename );
+}
+
 void AVXROctreeController::SaveOctreeElementDatas()
 {
     if ( ElementDataPath.Path.IsEmpty() || ElementDataFilename.IsEmpty() )
         return;
 
     AsyncTask( ENamedThreads::GameThread, [this]{
-        if ( RootOctree != nullptr  ) {
-            TArray<FString> elementDatas;
-            RootOctree->GetElementDatas( elementDatas );
+        if ( SpatialIndex.IsValid() && ElementDataFormat == EVXRElementDataFormat::Packed ) {
+            TArray<FVXRPackedSampleBlock> blocks;
+            SpatialIndex->GetPackedSampleBlocks( blocks );
+            if ( blocks.Num() > 0 ) {
+                auto saveFilePath = GetElementDataFilePath();
+                auto successed = VXRPackedSampleFile::Save( saveFilePath, blocks );
+                VXR_CLOG( successed, Log, TEXT( "#### Success save file. File Path:[%s] Blocks:[%d] ####" ), *saveFilePath, blocks.Num() );
+            }
+        }
+        else if ( SpatialIndex.IsValid() ) {
+            TArray<FVXRCameraData> cameraDatas;
+            SpatialIndex->GetCameraDatas( cameraDatas );
         
-            if ( elementDatas.Num() > 0 ) {
-                auto filename = FString::Printf( TEXT( "%s.txt" ), *ElementDataFilename );
-                auto saveFilePath = FPaths::Combine( ElementDataPath.Path, filename );
-                auto successed = FFileHelper::SaveStringArrayToFile( elementDatas, *saveFilePath );
-                VXR_CLOG( successed, Log, TEXT( "#### Success save file. File Name:[%s] ####" ), *filename );
-                if ( successed ) {
-                    for ( auto data : elementDatas )
-                        VXR_LOG( Log, TEXT( "#### %s ####" ), *data );
-                }
+            if ( cameraDatas.Num() > 0 ) {
+                auto saveFilePath = GetElementDataFilePath();
+                auto successed = TextCodec.SaveFile( saveFilePath, cameraDatas );
+                VXR_CLOG( successed, Log, TEXT( "#### Success save file. File Path:[%s] Elements:[%d] ####" ), *saveFilePath, cameraDatas.Num() );
             }
         }
     } );
@@ -198,36 +574,208 @@ void AVXROctreeController::SaveOctreeElementDatas()
 void AVXROctreeController::LoadOctreeElementDatas()
 {
     AsyncTask( ENamedThreads::GameThread, [this]{
-        if ( RootOctree != nullptr ) {
-            auto filename = FString::Printf( TEXT( "%s.txt" ), *ElementDataFilename );
-            auto loadFilePath = FPaths::Combine( ElementDataPath.Path, filename );
-            TArray<FString> lines;
-            auto successed = FFileHelper::LoadFileToStringArray( lines, *loadFilePath );
-            if ( successed ) {
-                TArray<FVXRCameraData> cameraDatas;
-                for ( auto line : lines ) {
-                    TArray<FString> data;
-                    line.ParseIntoArray( data, TEXT( ":" ), false );
-                    if ( !data[0].Equals( TEXT( "OctreeElement[Position, Yaw, Pitch]" ) ) )
-                        continue;
-
-                    TArray<FString> values;
-                    data[1].ParseIntoArray( values, TEXT( "," ), false );
-                    if ( values.Num() < 5 )
-                        continue;
-
-                    FVXRCameraData camData;
-                    camData.Position.X  = FCString::Atof( *values[0] );
-                    camData.Position.Y  = FCString::Atof( *values[1] );
-                    camData.Position.Z  = FCString::Atof( *values[2] );
-                    camData.OffsetYaw   = FCString::Atof( *values[3] );
-                    camData.OffsetPitch = FCString::Atof( *values[4] );
-                    cameraDatas.Add( camData );
-                }
+        if ( !SpatialIndex.IsValid() )
+            return;
 
-                if ( cameraDatas.Num() > 0 )
-                    RootOctree->BuildOctreeWithCameraDatas( cameraDatas );
-            }
+        // Loading over existing samples would duplicate them, so only the differences are applied.
+        if ( SpatialIndex->Num() > 0 ) {
+            StartElementDataReload();
+            return;
         }
+
+        TArray<FVXRCameraData> cameraDatas;
+        LoadElementDataFile( GetElementDataFilePath(), ElementDataFormat, TextCodec, cameraDatas, LastMalformedLineCount );
+
+        MarkIndexChanged();
+        if ( VersionedIndex != nullptr )
+            VersionedIndex->BeginEditGroup();
+
+        for ( auto& data : cameraDatas )
+            SpatialIndex->Insert( data );
+
+        if ( VersionedIndex != nullptr )
+            VersionedIndex->EndEditGroup();
     } );
 }
+
+//-----------------------------------------------------------------------------
+
+bool AVXROctreeController::StartCalibrationAnalysis()
+{
+    if ( AnalysisInProgress || !SpatialIndex.IsValid() )
+        return false;
+
+    AnalysisInProgress = true;
+
+    TArray<FVXRCameraData> cameraDatas;
+    SpatialIndex->GetCameraDatas( cameraDatas );
+
+    TWeakObjectPtr<AVXROctreeController> weakThis( this );
+    auto cellSize = AnalysisCellSize;
+    auto suggestionCount = AnalysisSuggestionCount;
+    AsyncTask( ENamedThreads::AnyBackgroundThreadNormalTask, [weakThis, cellSize, suggestionCount, cameraDatas = MoveTemp( cameraDatas )]{
+        FVXRCalibrationAnalysisResult result;
+        VXRCalibrationAnalysis::Analyze( cameraDatas, cellSize, suggestionCount, result );
+
+        AsyncTask( ENamedThreads::GameThread, [weakThis, result = MoveTemp( result )]{
+            if ( !weakThis.IsValid() )
+                return;
+
+            weakThis->AnalysisInProgress = false;
+            weakThis->LastAnalysisResult = result;
+            weakThis->OnCalibrationAnalyzed.Broadcast( weakThis->LastAnalysisResult );
+        } );
+    } );
+
+    return true;
+}
+
+void AVXROctreeController::DrawCalibrationAnalysis( float InLifeTime ) const
+{
+    auto& result = LastAnalysisResult;
+    auto halfCell = FVector( 0.5f * result.CellSize );
+    for ( auto& cell : result.Cells ) {
+        // Coverage gaps in blue, occupied cells from green to red by mean error.
+        auto alpha = FMath::Clamp( cell.MeanError / AnalysisErrorScale, 0.0f, 1.0f );
+        auto color = cell.SampleCount == 0 ? FColor::Blue : FLinearColor::LerpUsingHSV( FLinearColor::Green, FLinearColor::Red, alpha ).ToFColor( true );
+        DrawDebugBox( GetWorld(), cell.Center, halfCell, color, false, InLifeTime );
+    }
+
+    for ( auto& suggestion : result.Suggestions )
+        DrawDebugSphere( GetWorld(), suggestion.Position, 0.25f * result.CellSize, 8, FColor::Yellow, false, InLifeTime );
+}
+
+//-----------------------------------------------------------------------------
+
+void AVXROctreeController::StartElementDataReload()
+{
+    if ( !SpatialIndex.IsValid() || ElementDataPath.Path.IsEmpty() || ElementDataFilename.IsEmpty() )
+        return;
+
+    if ( ReloadInProgress || PendingChanges.Num() > 0 ) {
+        ReloadRequested = true;
+        return;
+    }
+
+    ReloadInProgress = true;
+    ReloadRequested = false;
+
+    TArray<FVXRCameraData> liveDatas;
+    SpatialIndex->GetCameraDatas( liveDatas );
+
+    TWeakObjectPtr<AVXROctreeController> weakThis( this );
+    auto filePath = GetElementDataFilePath();
+    auto format = ElementDataFormat;
+    auto keyResolution = HotReloadKeyResolution;
+    AsyncTask( ENamedThreads::AnyBackgroundThreadNormalTask, [weakThis, filePath, format, keyResolution, liveDatas = MoveTemp( liveDatas )]{
+        FVXRCalibrationTextCodec textCodec;
+        TArray<FVXRCameraData> newDatas;
+        int32 malformedLineCount = 0;
+        auto loaded = LoadElementDataFile( filePath, format, textCodec, newDatas, malformedLineCount );
+
+        TArray<FVXRElementDataChange> changes;
+        if ( loaded )
+            VXRElementDataDiff::Diff( liveDatas, newDatas, keyResolution, changes );
+
+        AsyncTask( ENamedThreads::GameThread, [weakThis, loaded, malformedLineCount, changes = MoveTemp( changes )]() mutable {
+            if ( !weakThis.IsValid() )
+                return;
+
+            if ( loaded )
+                weakThis->LastMalformedLineCount = malformedLineCount;
+            weakThis->FinishElementDataReload( MoveTemp( changes ) );
+        } );
+    } );
+}
+
+void AVXROctreeController::FinishElementDataReload( TArray<FVXRElementDataChange>&& InChanges )
+{
+    ReloadInProgress = false;
+    if ( !SpatialIndex.IsValid() )
+        return;
+
+    VXR_LOG( Log, TEXT( "#### Element data reload. File Path:[%s] Changes:[%d] ####" ), *GetElementDataFilePath(), InChanges.Num() );
+
+    PendingChanges = MoveTemp( InChanges );
+    PendingChangeIndex = 0;
+
+    if ( PendingChanges.Num() == 0 && ReloadRequested )
+        StartElementDataReload();
+}
+
+void AVXROctreeController::ApplyElementDataChanges()
+{
+    if ( PendingChanges.Num() == 0 )
+        return;
+
+    if ( !SpatialIndex.IsValid() ) {
+        PendingChanges.Reset();
+        PendingChangeIndex = 0;
+        return;
+    }
+
+    // Bounded per frame so a large edit does not hitch; remove and insert of an update stay in one frame.
+    // The diff was made against a snapshot, so every change is rebased on the current state of the key it
+    // touches: removes and updates only act on the unchanged snapshot sample, inserts only fill a key that
+    // is still empty. Edits made since the snapshot (e.g. streamed captures) win.
+    // Each batch is its own undo step on the versioned backend, so no edit group stays open across frames.
+    if ( VersionedIndex != nullptr )
+        VersionedIndex->BeginEditGroup();
+
+    TArray<FVXRCameraData> scratch;
+    int32 rejectedCount = 0;
+    auto last = FMath::Min( PendingChangeIndex + FMath::Max( HotReloadBatchSize, 1 ), PendingChanges.Num() );
+    for ( ; PendingChangeIndex < last; ++PendingChangeIndex ) {
+        auto& change = PendingChanges[PendingChangeIndex];
+        switch ( change.Type ) {
+            case EVXRElementDataChangeType::Remove:
+                if ( ContainsSample( *SpatialIndex, change.LiveCameraData, scratch ) )
+                    SpatialIndex->Remove( change.LiveCameraData.Position, KINDA_SMALL_NUMBER );
+                break;
+
+            case EVXRElementDataChangeType::Update:
+                if ( ContainsSample( *SpatialIndex, change.LiveCameraData, scratch ) && 
+                     SpatialIndex->Remove( change.LiveCameraData.Position, KINDA_SMALL_NUMBER ) && 
+                     !SpatialIndex->Insert( change.CameraData ) ) {
+                    // Keep the old offsets rather than losing the sample.
+                    ++rejectedCount;
+                    SpatialIndex->Insert( change.LiveCameraData );
+                }
+                break;
+
+            default:
+                if ( !ContainsPositionKey( *SpatialIndex, change.CameraData.Position, HotReloadKeyResolution, scratch ) && 
+                     !SpatialIndex->Insert( change.CameraData ) )
+                    ++rejectedCount;
+                break;
+        }
+    }
+
+    if ( VersionedIndex != nullptr )
+        VersionedIndex->EndEditGroup();
+
+    MarkIndexChanged();
+    VXR_CLOG( rejectedCount > 0, Warning, TEXT( "#### Element data reload rejected samples. File Path:[%s] Rejected:[%d] ####" ), 
+        *GetElementDataFilePath(), rejectedCount );
+
+    if ( PendingChangeIndex < PendingChanges.Num() )
+        return;
+
+    PendingChanges.Reset();
+    PendingChangeIndex = 0;
+    if ( ReloadRequested )
+        StartElementDataReload();
+}
+
+void AVXROctreeController::OnElementDataDirectoryChanged( const TArray<FFileChangeData>& InFileChanges )
+{
+#if VXR_WITH_HOT_RELOAD
+    auto filePath = FPaths::ConvertRelativePathToFull( GetElementDataFilePath() );
+    for ( auto& fileChange : InFileChanges ) {
+        if ( fileChange.Action != FFileChangeData::FCA_Removed && FPaths::IsSamePath( fileChange.Filename, filePath ) ) {
+            StartElementDataReload();
+            return;
+        }
+    }
+#endif
+}
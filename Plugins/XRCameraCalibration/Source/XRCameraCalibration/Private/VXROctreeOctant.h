@@ -0,0 +1,31 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+
+// Child layout shared by every octree: octant index bit 0 is +X, bit 1 is +Y and bit 2 is -Z, which
+// keeps the original AVXROctree child order (top back left first, bottom front right last).
+namespace VXROctreeOctant
+{
+    // Child origin offsets in units of the child extent.
+    constexpr float Offsets[8][3] = {
+        { -1.0f, -1.0f,  1.0f },
+        {  1.0f, -1.0f,  1.0f },
+        { -1.0f,  1.0f,  1.0f },
+        {  1.0f,  1.0f,  1.0f },
+        { -1.0f, -1.0f, -1.0f },
+        {  1.0f, -1.0f, -1.0f },
+        { -1.0f,  1.0f, -1.0f },
+        {  1.0f,  1.0f, -1.0f },
+    };
+
+    FORCEINLINE int32 GetOctant( const FVector& InOrigin, const FVector& InPosition )
+    {
+        return (InPosition.X >= InOrigin.X ? 1 : 0) | (InPosition.Y >= InOrigin.Y ? 2 : 0) | (InPosition.Z < InOrigin.Z ? 4 : 0);
+    }
+
+    FORCEINLINE FVector GetChildOrigin( const FVector& InOrigin, const FVector& InChildExtent, int32 InOctant )
+    {
+        return InOrigin + FVector( Offsets[InOctant][0] * InChildExtent.X, Offsets[InOctant][1] * InChildExtent.Y,
+            Offsets[InOctant][2] * InChildExtent.Z );
+    }
+}
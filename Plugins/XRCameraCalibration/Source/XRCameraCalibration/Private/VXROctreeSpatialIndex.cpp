@@ -0,0 +1,64 @@
+#include "VXROctreeSpatialIndex.h"
+#include "VXROctree.h"
+
+FVXROctreeSpatialIndex::FVXROctreeSpatialIndex( AVXROctree* InRootOctree )
+    : RootOctree( InRootOctree )
+{
+}
+
+bool FVXROctreeSpatialIndex::Insert( const FVXRCameraData& InCameraData )
+{
+    if ( RootOctree.IsValid() )
+        return RootOctree->InsertElementInOctree( InCameraData.Position, InCameraData.OffsetYaw, InCameraData.OffsetPitch );
+
+    return false;
+}
+
+bool FVXROctreeSpatialIndex::Remove( const FVector& InPosition, float InTolerance )
+{
+    if ( RootOctree.IsValid() )
+        return RootOctree->RemoveElementInOctree( InPosition, InTolerance );
+
+    return false;
+}
+
+int32 FVXROctreeSpatialIndex::FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const
+{
+    if ( RootOctree.IsValid() )
+        return RootOctree->FindNearestSamples( InPosition, OutCameraDatas, InCount );
+
+    return 0;
+}
+
+void FVXROctreeSpatialIndex::QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( RootOctree.IsValid() )
+        RootOctree->QueryBox( InBox, OutCameraDatas );
+}
+
+void FVXROctreeSpatialIndex::GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( RootOctree.IsValid() )
+        RootOctree->GetCameraDatas( OutCameraDatas );
+}
+
+void FVXROctreeSpatialIndex::GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const
+{
+    if ( RootOctree.IsValid() )
+        RootOctree->GetPackedSampleBlocks( OutBlocks );
+}
+
+int32 FVXROctreeSpatialIndex::Num() const
+{
+    return RootOctree.IsValid() ? RootOctree->GetElementCount() : 0;
+}
+
+const TCHAR* FVXROctreeSpatialIndex::GetName() const
+{
+    return TEXT( "Octree" );
+}
+
+AVXROctree* FVXROctreeSpatialIndex::GetRootOctree() const
+{
+    return RootOctree.Get();
+}
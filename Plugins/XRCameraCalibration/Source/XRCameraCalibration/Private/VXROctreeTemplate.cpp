@@ -0,0 +1,5 @@
+#include "VXROctreeTemplate.h"
+
+template class TVXROctree<8, FVXRCameraData>;
+template class TVXROctree<16, FVXRCameraData>;
+template class TVXROctree<32, FVXRCameraData>;
@@ -0,0 +1,375 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "Algo/Sort.h"
+#include "VXRCameraData.h"
+#include "VXRSpatialIndex.h"
+#include "VXROctreeOctant.h"
+
+template<typename PayloadType>
+struct TVXROctreePayloadTraits
+{
+    static FORCEINLINE const FVector& GetPosition( const PayloadType& InPayload ) { return InPayload.Position; }
+};
+
+//-----------------------------------------------------------------------------
+
+// Octree with the leaf capacity fixed at compile time. Nodes live in one array, store up to LeafCapacity
+// payloads inline and reference their eight children as a single first-child index, so a lookup touches
+// no per-node heap allocation and leaf distance loops run over the whole inline array. Leaves at the
+// maximum depth keep further payloads in a shared side array of overflow lists instead of rejecting them.
+template<int32 LeafCapacity, typename PayloadType>
+class TVXROctree
+{
+    static_assert( LeafCapacity > 0, "TVXROctree needs a positive leaf capacity." );
+
+public:
+    typedef TVXROctreePayloadTraits<PayloadType> FTraits;
+
+    TVXROctree( const FVector& InOrigin, const FVector& InExtent, int32 InMaxDepth );
+
+    // Fails only for payloads outside the root bounds.
+    bool Insert( const PayloadType& InPayload );
+    // Removes the payload closest to InPosition if it lies within InTolerance.
+    bool Remove( const FVector& InPosition, float InTolerance );
+
+    int32 FindNearest( const FVector& InPosition, PayloadType* OutPayloads, int32 InCount ) const;
+    void QueryBox( const FBox& InBox, TArray<PayloadType>& OutPayloads ) const;
+
+    // Calls InFunc( Origin, Extent, Payloads, Count ) for every non-empty leaf, a second time for the
+    // overflow payloads of a leaf at the maximum depth.
+    template<typename FuncType>
+    void ForEachLeaf( FuncType&& InFunc ) const
+    {
+        for ( auto& node : Nodes ) {
+            if ( node.FirstChild == INDEX_NONE && node.Count > 0 )
+                InFunc( node.Origin, LevelExtents[node.Depth], node.Items, node.Count );
+            if ( node.Overflow != INDEX_NONE && Overflows[node.Overflow].Num() > 0 )
+                InFunc( node.Origin, LevelExtents[node.Depth], Overflows[node.Overflow].GetData(), Overflows[node.Overflow].Num() );
+        }
+    }
+
+    void Reset();
+    int32 Num() const;
+    int32 GetNodeCount() const;
+    SIZE_T GetAllocatedSize() const;
+
+public:
+    static const int32 DepthLimit = 16;
+
+private:
+    struct FNode
+    {
+        FVector Origin;
+        int32 Depth;
+        // INDEX_NONE for leaves, otherwise the index of eight consecutive children.
+        int32 FirstChild;
+        int32 Count;
+        // Index into Overflows, only set for full leaves at the maximum depth.
+        int32 Overflow;
+        // Slots from Count on hold zeroed or stale payloads; leaf loops scan them but never report them.
+        PayloadType Items[LeafCapacity];
+    };
+
+    typedef IVXRSpatialIndex::TNearestList<PayloadType> FNearestList;
+
+    FBox GetNodeBox( const FNode& InNode ) const;
+    void Split( int32 InNodeIndex );
+    void AddSubtree( const FNode& InNode, TArray<PayloadType>& OutPayloads ) const;
+    void SearchNearest( const FNode& InNode, const FVector& InPosition, int32 InCount, FNearestList& InOutNearest ) const;
+    void SearchBox( const FNode& InNode, const FBox& InBox, TArray<PayloadType>& OutPayloads ) const;
+    void SearchClosest( int32 InNodeIndex, const FVector& InPosition, float& InOutDistSq, int32& OutNodeIndex, int32& OutItemIndex ) const;
+
+private:
+    TArray<FNode> Nodes;
+    TArray<TArray<PayloadType>> Overflows;
+    FVector LevelExtents[DepthLimit];
+    int32 MaxDepth;
+    int32 SampleCount;
+};
+
+//-----------------------------------------------------------------------------
+
+template<int32 LeafCapacity, typename PayloadType>
+TVXROctree<LeafCapacity, PayloadType>::TVXROctree( const FVector& InOrigin, const FVector& InExtent, int32 InMaxDepth )
+    : MaxDepth( FMath::Clamp( InMaxDepth, 1, DepthLimit ) )
+    , SampleCount( 0 )
+{
+    LevelExtents[0] = InExtent.GetAbs();
+    for ( int32 i = 1; i < DepthLimit; ++i )
+        LevelExtents[i] = LevelExtents[i - 1] * 0.5f;
+
+    auto& root = Nodes.AddZeroed_GetRef();
+    root.Origin = InOrigin;
+    root.FirstChild = INDEX_NONE;
+    root.Overflow = INDEX_NONE;
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+FBox TVXROctree<LeafCapacity, PayloadType>::GetNodeBox( const FNode& InNode ) const
+{
+    return FBox::BuildAABB( InNode.Origin, LevelExtents[InNode.Depth] );
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+bool TVXROctree<LeafCapacity, PayloadType>::Insert( const PayloadType& InPayload )
+{
+    auto& position = FTraits::GetPosition( InPayload );
+    if ( !GetNodeBox( Nodes[0] ).IsInsideOrOn( position ) )
+        return false;
+
+    int32 nodeIndex = 0;
+    for ( ;; ) {
+        auto& node = Nodes[nodeIndex];
+        if ( node.FirstChild != INDEX_NONE ) {
+            nodeIndex = node.FirstChild + VXROctreeOctant::GetOctant( node.Origin, position );
+            continue;
+        }
+
+        if ( node.Count < LeafCapacity ) {
+            node.Items[node.Count++] = InPayload;
+            ++SampleCount;
+            return true;
+        }
+
+        if ( node.Depth + 1 >= MaxDepth ) {
+            if ( node.Overflow == INDEX_NONE )
+                node.Overflow = Overflows.AddDefaulted();
+            Overflows[node.Overflow].Add( InPayload );
+            ++SampleCount;
+            return true;
+        }
+
+        // Split reallocates Nodes, the loop fetches the node again.
+        Split( nodeIndex );
+    }
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+void TVXROctree<LeafCapacity, PayloadType>::Split( int32 InNodeIndex )
+{
+    auto firstChild = Nodes.Num();
+    Nodes.AddZeroed( 8 );
+
+    auto& parent = Nodes[InNodeIndex];
+    auto childDepth = parent.Depth + 1;
+    for ( int32 octant = 0; octant < 8; ++octant ) {
+        auto& child = Nodes[firstChild + octant];
+        child.Origin = VXROctreeOctant::GetChildOrigin( parent.Origin, LevelExtents[childDepth], octant );
+        child.Depth = childDepth;
+        child.FirstChild = INDEX_NONE;
+        child.Overflow = INDEX_NONE;
+    }
+
+    for ( int32 i = 0; i < LeafCapacity; ++i ) {
+        auto& child = Nodes[firstChild + VXROctreeOctant::GetOctant( parent.Origin, FTraits::GetPosition( parent.Items[i] ) )];
+        child.Items[child.Count++] = parent.Items[i];
+    }
+
+    parent.Count = 0;
+    parent.FirstChild = firstChild;
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+bool TVXROctree<LeafCapacity, PayloadType>::Remove( const FVector& InPosition, float InTolerance )
+{
+    auto distSq = FMath::Square( InTolerance );
+    int32 nodeIndex = INDEX_NONE;
+    int32 itemIndex = INDEX_NONE;
+    SearchClosest( 0, InPosition, distSq, nodeIndex, itemIndex );
+    if ( nodeIndex == INDEX_NONE )
+        return false;
+
+    // Item indices from LeafCapacity on address the overflow payloads.
+    auto& node = Nodes[nodeIndex];
+    auto overflow = node.Overflow != INDEX_NONE ? &Overflows[node.Overflow] : nullptr;
+    if ( itemIndex >= LeafCapacity )
+        overflow->RemoveAtSwap( itemIndex - LeafCapacity, 1, false );
+    else if ( overflow != nullptr && overflow->Num() > 0 )
+        node.Items[itemIndex] = overflow->Pop( false );
+    else
+        node.Items[itemIndex] = node.Items[--node.Count];
+
+    --SampleCount;
+    return true;
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+void TVXROctree<LeafCapacity, PayloadType>::SearchClosest( int32 InNodeIndex, const FVector& InPosition, float& InOutDistSq,
+    int32& OutNodeIndex, int32& OutItemIndex ) const
+{
+    auto& node = Nodes[InNodeIndex];
+    if ( !FMath::SphereAABBIntersection( InPosition, InOutDistSq, GetNodeBox( node ) ) )
+        return;
+
+    if ( node.FirstChild != INDEX_NONE ) {
+        for ( int32 octant = 0; octant < 8; ++octant )
+            SearchClosest( node.FirstChild + octant, InPosition, InOutDistSq, OutNodeIndex, OutItemIndex );
+        return;
+    }
+
+    float distSq[LeafCapacity];
+    for ( int32 i = 0; i < LeafCapacity; ++i )
+        distSq[i] = FVector::DistSquared( InPosition, FTraits::GetPosition( node.Items[i] ) );
+
+    for ( int32 i = 0; i < node.Count; ++i ) {
+        if ( distSq[i] <= InOutDistSq ) {
+            InOutDistSq = distSq[i];
+            OutNodeIndex = InNodeIndex;
+            OutItemIndex = i;
+        }
+    }
+
+    if ( node.Overflow == INDEX_NONE )
+        return;
+
+    auto& overflow = Overflows[node.Overflow];
+    for ( int32 i = 0; i < overflow.Num(); ++i ) {
+        auto overflowDistSq = FVector::DistSquared( InPosition, FTraits::GetPosition( overflow[i] ) );
+        if ( overflowDistSq <= InOutDistSq ) {
+            InOutDistSq = overflowDistSq;
+            OutNodeIndex = InNodeIndex;
+            OutItemIndex = LeafCapacity + i;
+        }
+    }
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+int32 TVXROctree<LeafCapacity, PayloadType>::FindNearest( const FVector& InPosition, PayloadType* OutPayloads, int32 InCount ) const
+{
+    if ( SampleCount == 0 || InCount <= 0 )
+        return 0;
+
+    FNearestList nearest;
+    SearchNearest( Nodes[0], InPosition, InCount, nearest );
+
+    for ( int32 i = 0; i < nearest.Num(); ++i )
+        OutPayloads[i] = nearest[i].Value;
+
+    return nearest.Num();
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+void TVXROctree<LeafCapacity, PayloadType>::SearchNearest( const FNode& InNode, const FVector& InPosition, int32 InCount,
+    FNearestList& InOutNearest ) const
+{
+    if ( InNode.FirstChild == INDEX_NONE ) {
+        float distSq[LeafCapacity];
+        for ( int32 i = 0; i < LeafCapacity; ++i )
+            distSq[i] = FVector::DistSquared( InPosition, FTraits::GetPosition( InNode.Items[i] ) );
+
+        for ( int32 i = 0; i < InNode.Count; ++i )
+            IVXRSpatialIndex::AddNearestCandidate( InOutNearest, InCount, distSq[i], InNode.Items[i] );
+
+        if ( InNode.Overflow != INDEX_NONE ) {
+            for ( auto& payload : Overflows[InNode.Overflow] )
+                IVXRSpatialIndex::AddNearestCandidate( InOutNearest, InCount, FVector::DistSquared( InPosition, FTraits::GetPosition( payload ) ), payload );
+        }
+        return;
+    }
+
+    // Children closest first, so the k-th distance shrinks early and prunes the rest.
+    TPair<float, int32> order[8];
+    for ( int32 octant = 0; octant < 8; ++octant ) {
+        auto childIndex = InNode.FirstChild + octant;
+        order[octant] = TPair<float, int32>( GetNodeBox( Nodes[childIndex] ).ComputeSquaredDistanceToPoint( InPosition ), childIndex );
+    }
+    Algo::Sort( order, []( const TPair<float, int32>& InA, const TPair<float, int32>& InB ){ return InA.Key < InB.Key; } );
+
+    for ( auto& child : order ) {
+        if ( InOutNearest.Num() == InCount && child.Key >= InOutNearest.Last().Key )
+            break;
+
+        SearchNearest( Nodes[child.Value], InPosition, InCount, InOutNearest );
+    }
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+void TVXROctree<LeafCapacity, PayloadType>::QueryBox( const FBox& InBox, TArray<PayloadType>& OutPayloads ) const
+{
+    SearchBox( Nodes[0], InBox, OutPayloads );
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+void TVXROctree<LeafCapacity, PayloadType>::SearchBox( const FNode& InNode, const FBox& InBox, TArray<PayloadType>& OutPayloads ) const
+{
+    auto nodeBox = GetNodeBox( InNode );
+    if ( !InBox.Intersect( nodeBox ) )
+        return;
+
+    if ( InBox.IsInsideOrOn( nodeBox.Min ) && InBox.IsInsideOrOn( nodeBox.Max ) ) {
+        AddSubtree( InNode, OutPayloads );
+        return;
+    }
+
+    if ( InNode.FirstChild != INDEX_NONE ) {
+        for ( int32 octant = 0; octant < 8; ++octant )
+            SearchBox( Nodes[InNode.FirstChild + octant], InBox, OutPayloads );
+        return;
+    }
+
+    for ( int32 i = 0; i < InNode.Count; ++i ) {
+        if ( InBox.IsInsideOrOn( FTraits::GetPosition( InNode.Items[i] ) ) )
+            OutPayloads.Add( InNode.Items[i] );
+    }
+    if ( InNode.Overflow != INDEX_NONE ) {
+        for ( auto& payload : Overflows[InNode.Overflow] ) {
+            if ( InBox.IsInsideOrOn( FTraits::GetPosition( payload ) ) )
+                OutPayloads.Add( payload );
+        }
+    }
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+void TVXROctree<LeafCapacity, PayloadType>::AddSubtree( const FNode& InNode, TArray<PayloadType>& OutPayloads ) const
+{
+    if ( InNode.FirstChild == INDEX_NONE ) {
+        OutPayloads.Append( InNode.Items, InNode.Count );
+        if ( InNode.Overflow != INDEX_NONE )
+            OutPayloads.Append( Overflows[InNode.Overflow] );
+        return;
+    }
+
+    for ( int32 octant = 0; octant < 8; ++octant )
+        AddSubtree( Nodes[InNode.FirstChild + octant], OutPayloads );
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+void TVXROctree<LeafCapacity, PayloadType>::Reset()
+{
+    Nodes.SetNum( 1 );
+    Nodes[0].FirstChild = INDEX_NONE;
+    Nodes[0].Count = 0;
+    Nodes[0].Overflow = INDEX_NONE;
+    Overflows.Empty();
+    SampleCount = 0;
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+int32 TVXROctree<LeafCapacity, PayloadType>::Num() const
+{
+    return SampleCount;
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+int32 TVXROctree<LeafCapacity, PayloadType>::GetNodeCount() const
+{
+    return Nodes.Num();
+}
+
+template<int32 LeafCapacity, typename PayloadType>
+SIZE_T TVXROctree<LeafCapacity, PayloadType>::GetAllocatedSize() const
+{
+    auto size = Nodes.GetAllocatedSize() + Overflows.GetAllocatedSize();
+    for ( auto& overflow : Overflows )
+        size += overflow.GetAllocatedSize();
+
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+
+// Common configurations, instantiated once in VXROctreeTemplate.cpp. 16 backs FVXRCompactOctreeSpatialIndex.
+extern template class TVXROctree<8, FVXRCameraData>;
+extern template class TVXROctree<16, FVXRCameraData>;
+extern template class TVXROctree<32, FVXRCameraData>;
@@ -0,0 +1,111 @@
+#include "VXRPackedSample.h"
+#include "HAL/FileManager.h"
+#include "Serialization/Archive.h"
+#include "VXRLog.h"
+
+namespace VXRPackedSampleFile
+{
+    static const uint32 FileMagic = 0x43525856; // 'VXRC'
+    static const int32 FileVersion = 1;
+}
+
+namespace
+{
+    const float QuantizeRange = 65535.0f;
+
+    uint16 QuantizeAxis( float InValue, float InOrigin, float InExtent )
+    {
+        if ( InExtent <= KINDA_SMALL_NUMBER )
+            return 0;
+
+        auto alpha = (InValue - (InOrigin - InExtent)) / (2.0f * InExtent);
+        return (uint16)FMath::Clamp( FMath::RoundToInt( alpha * QuantizeRange ), 0, 65535 );
+    }
+
+    float DequantizeAxis( uint16 InValue, float InOrigin, float InExtent )
+    {
+        return (InOrigin - InExtent) + (2.0f * InExtent) * ((float)InValue / QuantizeRange);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+FVXRPackedSample FVXRPackedSample::Encode( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch,
+    const FVector& InBoundsOrigin, const FVector& InBoundsExtent )
+{
+    FVXRPackedSample sample;
+    sample.X = QuantizeAxis( InPosition.X, InBoundsOrigin.X, InBoundsExtent.X );
+    sample.Y = QuantizeAxis( InPosition.Y, InBoundsOrigin.Y, InBoundsExtent.Y );
+    sample.Z = QuantizeAxis( InPosition.Z, InBoundsOrigin.Z, InBoundsExtent.Z );
+    sample.OffsetYaw = FFloat16( InOffsetYaw );
+    sample.OffsetPitch = FFloat16( InOffsetPitch );
+    return sample;
+}
+
+FVector FVXRPackedSample::DecodePosition( const FVector& InBoundsOrigin, const FVector& InBoundsExtent ) const
+{
+    return FVector( DequantizeAxis( X, InBoundsOrigin.X, InBoundsExtent.X ),
+        DequantizeAxis( Y, InBoundsOrigin.Y, InBoundsExtent.Y ),
+        DequantizeAxis( Z, InBoundsOrigin.Z, InBoundsExtent.Z ) );
+}
+
+FVXRCameraData FVXRPackedSample::Decode( const FVector& InBoundsOrigin, const FVector& InBoundsExtent ) const
+{
+    FVXRCameraData data;
+    data.Position = DecodePosition( InBoundsOrigin, InBoundsExtent );
+    data.OffsetYaw = OffsetYaw;
+    data.OffsetPitch = OffsetPitch;
+    return data;
+}
+
+FArchive& operator<<( FArchive& Ar, FVXRPackedSample& InSample )
+{
+    Ar << InSample.X << InSample.Y << InSample.Z;
+    Ar << InSample.OffsetYaw.Encoded << InSample.OffsetPitch.Encoded;
+    return Ar;
+}
+
+FArchive& operator<<( FArchive& Ar, FVXRPackedSampleBlock& InBlock )
+{
+    Ar << InBlock.Origin << InBlock.Extent;
+    Ar << InBlock.Samples;
+    return Ar;
+}
+
+//-----------------------------------------------------------------------------
+
+bool VXRPackedSampleFile::Save( const FString& InFilePath, const TArray<FVXRPackedSampleBlock>& InBlocks )
+{
+    TUniquePtr<FArchive> writer( IFileManager::Get().CreateFileWriter( *InFilePath ) );
+    if ( !writer.IsValid() ) {
+        VXR_LOG( Warning, TEXT( "#### Cannot open packed element file for write. File Path:[%s] ####" ), *InFilePath );
+        return false;
+    }
+
+    uint32 magic = FileMagic;
+    int32 version = FileVersion;
+    *writer << magic << version;
+    *writer << const_cast<TArray<FVXRPackedSampleBlock>&>( InBlocks );
+
+    return writer->Close();
+}
+
+bool VXRPackedSampleFile::Load( const FString& InFilePath, TArray<FVXRPackedSampleBlock>& OutBlocks )
+{
+    TUniquePtr<FArchive> reader( IFileManager::Get().CreateFileReader( *InFilePath ) );
+    if ( !reader.IsValid() ) {
+        VXR_LOG( Warning, TEXT( "#### Cannot open packed element file for read. File Path:[%s] ####" ), *InFilePath );
+        return false;
+    }
+
+    uint32 magic = 0;
+    int32 version = 0;
+    *reader << magic << version;
+    if ( magic != FileMagic || version > FileVersion ) {
+        VXR_LOG( Warning, TEXT( "#### Invalid packed element file. File Path:[%s] Version:[%d] ####" ), *InFilePath, version );
+        return false;
+    }
+
+    *reader << OutBlocks;
+    return !reader->IsError() && reader->Close();
+}
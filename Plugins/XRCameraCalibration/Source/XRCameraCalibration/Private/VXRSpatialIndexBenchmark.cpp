@@ -0,0 +1,127 @@
+#include "VXROctree.h"
+#include "VXROctreeController.h"
+#include "VXROctreeSpatialIndex.h"
+#include "VXRHashGridSpatialIndex.h"
+#include "VXRVersionedOctreeSpatialIndex.h"
+#include "VXRCompactOctreeSpatialIndex.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "VXRLog.h"
+
+namespace
+{
+    struct FBenchmarkWorkload
+    {
+        TArray<FVXRCameraData> Samples;
+        TArray<FVector> QueryPositions;
+        TArray<FBox> QueryBoxes;
+        float Extent;
+    };
+
+    double ElapsedMs( uint64 InStartCycles )
+    {
+        return FPlatformTime::ToMilliseconds64( FPlatformTime::Cycles64() - InStartCycles );
+    }
+
+    void BuildWorkload( int32 InSampleCount, int32 InQueryCount, float InExtent, FBenchmarkWorkload& OutWorkload )
+    {
+        FRandomStream random( 0x56585243 );
+        auto randomPosition = [&random, InExtent]{
+            return FVector( random.FRandRange( -InExtent, InExtent ), random.FRandRange( -InExtent, InExtent ),
+                random.FRandRange( -InExtent, InExtent ) );
+        };
+
+        OutWorkload.Extent = InExtent;
+        for ( int32 i = 0; i < InSampleCount; ++i ) {
+            FVXRCameraData data;
+            data.Position = randomPosition();
+            data.OffsetYaw = random.FRandRange( -2.0f, 2.0f );
+            data.OffsetPitch = random.FRandRange( -2.0f, 2.0f );
+            OutWorkload.Samples.Add( data );
+        }
+
+        for ( int32 i = 0; i < InQueryCount; ++i ) {
+            OutWorkload.QueryPositions.Add( randomPosition() );
+            OutWorkload.QueryBoxes.Add( FBox::BuildAABB( randomPosition(), FVector( InExtent * 0.05f ) ) );
+        }
+    }
+
+    void RunWorkload( IVXRSpatialIndex& InIndex, const FBenchmarkWorkload& InWorkload )
+    {
+        auto start = FPlatformTime::Cycles64();
+        int32 inserted = 0;
+        for ( auto& sample : InWorkload.Samples )
+            inserted += InIndex.Insert( sample ) ? 1 : 0;
+        auto insertMs = ElapsedMs( start );
+
+        start = FPlatformTime::Cycles64();
+        int32 found = 0;
+        FVXRCameraData nearest[2];
+        for ( auto& position : InWorkload.QueryPositions )
+            found += InIndex.FindNearest( position, nearest, 2 );
+        auto nearestMs = ElapsedMs( start );
+
+        start = FPlatformTime::Cycles64();
+        TArray<FVXRCameraData> boxResults;
+        for ( auto& box : InWorkload.QueryBoxes ) {
+            boxResults.Reset();
+            InIndex.QueryBox( box, boxResults );
+            found += boxResults.Num();
+        }
+        auto boxMs = ElapsedMs( start );
+
+        start = FPlatformTime::Cycles64();
+        int32 removed = 0;
+        for ( int32 i = 0; i < InWorkload.Samples.Num(); i += 10 )
+            removed += InIndex.Remove( InWorkload.Samples[i].Position, 1.0f ) ? 1 : 0;
+        auto removeMs = ElapsedMs( start );
+
+        VXR_LOG( Log, TEXT( "#### Spatial index benchmark. Index:[%s] Inserted:[%d/%d] Insert:[%.3f ms] Nearest:[%.3f ms] Box:[%.3f ms] Remove:[%d, %.3f ms] Found:[%d] ####" ),
+            InIndex.GetName(), inserted, InWorkload.Samples.Num(), insertMs, nearestMs, boxMs, removed, removeMs, found );
+    }
+
+    void RunSpatialIndexBenchmark( const TArray<FString>& InArgs, UWorld* InWorld )
+    {
+        if ( InWorld == nullptr )
+            return;
+
+        // The octree keeps its configuration in statics shared by every tree, so do not disturb a live controller.
+        for ( TActorIterator<AVXROctreeController> it( InWorld ); it; ++it ) {
+            VXR_LOG( Warning, TEXT( "#### Spatial index benchmark skipped, an octree controller is active. Controller:[%s] ####" ),
+                *it->GetName() );
+            return;
+        }
+
+        auto sampleCount = InArgs.Num() > 0 ? FCString::Atoi( *InArgs[0] ) : 10000;
+        auto queryCount = InArgs.Num() > 1 ? FCString::Atoi( *InArgs[1] ) : 10000;
+        auto maxDepth = 4;
+        auto leafCount = 1 << (3 * (maxDepth - 1));
+
+        FBenchmarkWorkload workload;
+        BuildWorkload( sampleCount, queryCount, 1000.0f, workload );
+
+        auto rootOctree = AVXROctree::SpawnRootOctree( InWorld, FVector::ZeroVector, FVector( workload.Extent ), nullptr,
+            FMath::Max( 16, 4 * sampleCount / leafCount ), maxDepth, 0.1f, FColor::Blue, false );
+        if ( rootOctree != nullptr ) {
+            FVXROctreeSpatialIndex octreeIndex( rootOctree );
+            RunWorkload( octreeIndex, workload );
+            rootOctree->DestroyOctree();
+        }
+
+        FVXRHashGridSpatialIndex gridIndex( 2.0f * workload.Extent / (1 << (maxDepth - 1)) );
+        RunWorkload( gridIndex, workload );
+
+        FVXRVersionedOctreeSpatialIndex versionedIndex( FVector::ZeroVector, FVector( workload.Extent ), 16, 2 * maxDepth );
+        RunWorkload( versionedIndex, workload );
+
+        FVXRCompactOctreeSpatialIndex compactIndex( FVector::ZeroVector, FVector( workload.Extent ), 2 * maxDepth );
+        RunWorkload( compactIndex, workload );
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+static FAutoConsoleCommandWithWorldAndArgs GVXRSpatialIndexBenchmarkCommand(
+    TEXT( "vxr.SpatialIndex.Benchmark" ),
+    TEXT( "Runs the same insert/nearest/box/remove workload against every spatial index backend. Args: [SampleCount] [QueryCount]" ),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic( &RunSpatialIndexBenchmark ) );
@@ -0,0 +1,228 @@
+#include "VXRStaticKdTree.h"
+#include "VXRSpatialIndex.h"
+
+namespace
+{
+    struct FNearestQuery
+    {
+        const FVXRKdNode* Nodes;
+        const FVXRCameraData* Samples;
+        FVector Position;
+        int32 Count;
+        IVXRSpatialIndex::TNearestList<int32> Nearest;
+    };
+
+    void SearchNearest( FNearestQuery& InOutQuery, int32 InNodeIndex )
+    {
+        auto& node = InOutQuery.Nodes[InNodeIndex];
+        if ( node.Axis == INDEX_NONE ) {
+            for ( int32 i = node.Begin; i < node.Begin + node.Count; ++i )
+                IVXRSpatialIndex::AddNearestCandidate( InOutQuery.Nearest, InOutQuery.Count,
+                    FVector::DistSquared( InOutQuery.Position, InOutQuery.Samples[i].Position ), i );
+            return;
+        }
+
+        auto diff = InOutQuery.Position[node.Axis] - node.SplitValue;
+        auto nearChild = 2 * InNodeIndex + (diff < 0.0f ? 1 : 2);
+        auto farChild = 2 * InNodeIndex + (diff < 0.0f ? 2 : 1);
+
+        SearchNearest( InOutQuery, nearChild );
+        if ( InOutQuery.Nearest.Num() < InOutQuery.Count || FMath::Square( diff ) < InOutQuery.Nearest.Last().Key )
+            SearchNearest( InOutQuery, farChild );
+    }
+
+    void SelectNth( FVXRCameraData* InOutSamples, int32 InBegin, int32 InEnd, int32 InNth, int32 InAxis )
+    {
+        auto left = InBegin;
+        auto right = InEnd - 1;
+        while ( left < right ) {
+            auto pivot = InOutSamples[left + (right - left) / 2].Position[InAxis];
+            auto i = left;
+            auto j = right;
+            while ( i <= j ) {
+                while ( InOutSamples[i].Position[InAxis] < pivot )
+                    ++i;
+                while ( InOutSamples[j].Position[InAxis] > pivot )
+                    --j;
+                if ( i <= j ) {
+                    Swap( InOutSamples[i], InOutSamples[j] );
+                    ++i;
+                    --j;
+                }
+            }
+
+            if ( InNth <= j )
+                right = j;
+            else if ( InNth >= i )
+                left = i;
+            else
+                break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void FVXRStaticKdTree::Build( const TArray<FVXRCameraData>& InCameraDatas )
+{
+    Reset();
+
+    SampleCount = InCameraDatas.Num();
+    if ( SampleCount == 0 )
+        return;
+
+    // Median splits halve the sample count per level, so every leaf ends on the same level.
+    int32 leafLevel = 0;
+    while ( (SampleCount >> leafLevel) > LeafSize )
+        ++leafLevel;
+
+    NodeCount = (1 << (leafLevel + 1)) - 1;
+    Storage.SetNumUninitialized( NodeCount * sizeof( FVXRKdNode ) + SampleCount * sizeof( FVXRCameraData ) );
+    FMemory::Memcpy( GetMutableSamples(), InCameraDatas.GetData(), SampleCount * sizeof( FVXRCameraData ) );
+
+    BuildNode( 0, 0, SampleCount, 0, leafLevel );
+}
+
+void FVXRStaticKdTree::BuildNode( int32 InNodeIndex, int32 InBegin, int32 InEnd, int32 InLevel, int32 InLeafLevel )
+{
+    auto& node = GetMutableNodes()[InNodeIndex];
+    node.Begin = InBegin;
+    node.Count = InEnd - InBegin;
+
+    if ( InLevel == InLeafLevel ) {
+        node.Axis = INDEX_NONE;
+        node.SplitValue = 0.0f;
+        return;
+    }
+
+    auto samples = GetMutableSamples();
+    FBox bounds( ForceInit );
+    for ( int32 i = InBegin; i < InEnd; ++i )
+        bounds += samples[i].Position;
+
+    auto size = bounds.GetSize();
+    node.Axis = size.X >= size.Y && size.X >= size.Z ? 0 : (size.Y >= size.Z ? 1 : 2);
+
+    // The leaf level is chosen so that every inner node has at least one sample.
+    auto mid = InBegin + (InEnd - InBegin) / 2;
+    SelectNth( samples, InBegin, InEnd, mid, node.Axis );
+    node.SplitValue = samples[mid].Position[node.Axis];
+
+    BuildNode( 2 * InNodeIndex + 1, InBegin, mid, InLevel + 1, InLeafLevel );
+    BuildNode( 2 * InNodeIndex + 2, mid, InEnd, InLevel + 1, InLeafLevel );
+}
+
+bool FVXRStaticKdTree::InitFromStorage( const void* InData, int64 InSize, int32 InNodeCount, int32 InSampleCount )
+{
+    Reset();
+
+    if ( InNodeCount < 0 || InSampleCount < 0 || (InSampleCount > 0) != (InNodeCount > 0) )
+        return false;
+
+    if ( InSize != (int64)InNodeCount * sizeof( FVXRKdNode ) + (int64)InSampleCount * sizeof( FVXRCameraData ) )
+        return false;
+
+    NodeCount = InNodeCount;
+    SampleCount = InSampleCount;
+    Storage.SetNumUninitialized( (int32)InSize );
+    FMemory::Memcpy( Storage.GetData(), InData, InSize );
+    return true;
+}
+
+void FVXRStaticKdTree::Reset()
+{
+    Storage.Empty();
+    NodeCount = 0;
+    SampleCount = 0;
+}
+
+int32 FVXRStaticKdTree::FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const
+{
+    if ( IsEmpty() || InCount <= 0 )
+        return 0;
+
+    FNearestQuery query;
+    query.Nodes = GetNodes();
+    query.Samples = GetSamples();
+    query.Position = InPosition;
+    query.Count = InCount;
+    SearchNearest( query, 0 );
+
+    for ( int32 i = 0; i < query.Nearest.Num(); ++i )
+        OutCameraDatas[i] = query.Samples[query.Nearest[i].Value];
+
+    return query.Nearest.Num();
+}
+
+void FVXRStaticKdTree::QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( IsEmpty() )
+        return;
+
+    auto nodes = GetNodes();
+    auto samples = GetSamples();
+
+    TArray<int32, TInlineAllocator<64>> stack;
+    stack.Push( 0 );
+    while ( stack.Num() > 0 ) {
+        auto nodeIndex = stack.Pop( false );
+        auto& node = nodes[nodeIndex];
+        if ( node.Axis == INDEX_NONE ) {
+            for ( int32 i = node.Begin; i < node.Begin + node.Count; ++i ) {
+                if ( InBox.IsInsideOrOn( samples[i].Position ) )
+                    OutCameraDatas.Add( samples[i] );
+            }
+            continue;
+        }
+
+        if ( InBox.Min[node.Axis] <= node.SplitValue )
+            stack.Push( 2 * nodeIndex + 1 );
+        if ( InBox.Max[node.Axis] >= node.SplitValue )
+            stack.Push( 2 * nodeIndex + 2 );
+    }
+}
+
+bool FVXRStaticKdTree::IsEmpty() const
+{
+    return SampleCount == 0;
+}
+
+int32 FVXRStaticKdTree::Num() const
+{
+    return SampleCount;
+}
+
+int32 FVXRStaticKdTree::GetNodeCount() const
+{
+    return NodeCount;
+}
+
+SIZE_T FVXRStaticKdTree::GetAllocatedSize() const
+{
+    return Storage.GetAllocatedSize();
+}
+
+const FVXRKdNode* FVXRStaticKdTree::GetNodes() const
+{
+    return reinterpret_cast<const FVXRKdNode*>( Storage.GetData() );
+}
+
+const FVXRCameraData* FVXRStaticKdTree::GetSamples() const
+{
+    return reinterpret_cast<const FVXRCameraData*>( Storage.GetData() + NodeCount * sizeof( FVXRKdNode ) );
+}
+
+const TArray<uint8>& FVXRStaticKdTree::GetStorage() const
+{
+    return Storage;
+}
+
+FVXRKdNode* FVXRStaticKdTree::GetMutableNodes()
+{
+    return reinterpret_cast<FVXRKdNode*>( Storage.GetData() );
+}
+
+FVXRCameraData* FVXRStaticKdTree::GetMutableSamples()
+{
+    return reinterpret_cast<FVXRCameraData*>( Storage.GetData() + NodeCount * sizeof( FVXRKdNode ) );
+}
@@ -0,0 +1,327 @@
+#include "VXRVersionedOctreeSpatialIndex.h"
+#include "VXROctreeOctant.h"
+#include "VXRLog.h"
+
+struct FVXRVersionedOctreeNode
+{
+    // Leaves keep their samples, inner nodes keep up to eight children (null when empty).
+    TArray<FVXRCameraData> Samples;
+    TSharedPtr<const FVXRVersionedOctreeNode> Children[8];
+    bool IsLeaf = true;
+};
+
+namespace
+{
+    typedef IVXRSpatialIndex::TNearestList<FVXRCameraData> FNearestList;
+
+    void SearchNearest( const FVXRVersionedOctreeNode& InNode, const FVector& InCenter, const FVector& InExtent,
+        const FVector& InPosition, int32 InCount, FNearestList& InOutNearest )
+    {
+        if ( InNode.IsLeaf ) {
+            for ( auto& sample : InNode.Samples )
+                IVXRSpatialIndex::AddNearestCandidate( InOutNearest, InCount, FVector::DistSquared( InPosition, sample.Position ), sample );
+            return;
+        }
+
+        // Visit children closest first so the k-th distance shrinks early and prunes the rest.
+        TArray<TPair<float, int32>, TInlineAllocator<8>> order;
+        auto childExtent = InExtent * 0.5f;
+        for ( int32 octant = 0; octant < 8; ++octant ) {
+            if ( InNode.Children[octant].IsValid() ) {
+                auto childBox = FBox::BuildAABB( VXROctreeOctant::GetChildOrigin( InCenter, childExtent, octant ), childExtent );
+                order.Emplace( childBox.ComputeSquaredDistanceToPoint( InPosition ), octant );
+            }
+        }
+        order.Sort( []( const TPair<float, int32>& InA, const TPair<float, int32>& InB ){ return InA.Key < InB.Key; } );
+
+        for ( auto& child : order ) {
+            if ( InOutNearest.Num() == InCount && child.Key >= InOutNearest.Last().Key )
+                break;
+
+            SearchNearest( *InNode.Children[child.Value], VXROctreeOctant::GetChildOrigin( InCenter, childExtent, child.Value ), childExtent,
+                InPosition, InCount, InOutNearest );
+        }
+    }
+
+    void SearchBox( const FVXRVersionedOctreeNode& InNode, const FVector& InCenter, const FVector& InExtent, const FBox& InBox,
+        TArray<FVXRCameraData>& OutCameraDatas )
+    {
+        auto nodeBox = FBox::BuildAABB( InCenter, InExtent );
+        if ( !InBox.Intersect( nodeBox ) )
+            return;
+
+        if ( InNode.IsLeaf ) {
+            auto contained = InBox.IsInsideOrOn( nodeBox.Min ) && InBox.IsInsideOrOn( nodeBox.Max );
+            for ( auto& sample : InNode.Samples ) {
+                if ( contained || InBox.IsInsideOrOn( sample.Position ) )
+                    OutCameraDatas.Add( sample );
+            }
+            return;
+        }
+
+        auto childExtent = InExtent * 0.5f;
+        for ( int32 octant = 0; octant < 8; ++octant ) {
+            if ( InNode.Children[octant].IsValid() )
+                SearchBox( *InNode.Children[octant], VXROctreeOctant::GetChildOrigin( InCenter, childExtent, octant ), childExtent, InBox, OutCameraDatas );
+        }
+    }
+
+    template<typename LeafFunc>
+    void ForEachLeaf( const FVXRVersionedOctreeNode& InNode, const FVector& InCenter, const FVector& InExtent, LeafFunc&& InFunc )
+    {
+        if ( InNode.IsLeaf ) {
+            InFunc( InNode, InCenter, InExtent );
+            return;
+        }
+
+        auto childExtent = InExtent * 0.5f;
+        for ( int32 octant = 0; octant < 8; ++octant ) {
+            if ( InNode.Children[octant].IsValid() )
+                ForEachLeaf( *InNode.Children[octant], VXROctreeOctant::GetChildOrigin( InCenter, childExtent, octant ), childExtent, InFunc );
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+FVXRVersionedOctreeSpatialIndex::FVXRVersionedOctreeSpatialIndex( const FVector& InOrigin, const FVector& InExtent,
+    int32 InLeafCapacity, int32 InMaxDepth, int32 InMaxHistory )
+    : Origin( InOrigin )
+    , Extent( InExtent.GetAbs() )
+    , LeafCapacity( FMath::Max( InLeafCapacity, 1 ) )
+    , MaxDepth( FMath::Max( InMaxDepth, 1 ) )
+    , MaxHistory( FMath::Max( InMaxHistory, 0 ) )
+    , EditGroupDepth( 0 )
+    , EditGroupPushed( false )
+{
+}
+
+FVXRVersionedOctreeSpatialIndex::FNodePtr FVXRVersionedOctreeSpatialIndex::InsertNode( const FNodePtr& InNode, const FVector& InCenter,
+    const FVector& InExtent, int32 InDepth, const FVXRCameraData& InCameraData ) const
+{
+    if ( !InNode.IsValid() ) {
+        auto leaf = MakeShared<FVXRVersionedOctreeNode>();
+        leaf->Samples.Add( InCameraData );
+        return leaf;
+    }
+
+    if ( InNode->IsLeaf && (InNode->Samples.Num() < LeafCapacity || InDepth + 1 >= MaxDepth) ) {
+        auto leaf = MakeShared<FVXRVersionedOctreeNode>( *InNode );
+        leaf->Samples.Add( InCameraData );
+        return leaf;
+    }
+
+    auto childExtent = InExtent * 0.5f;
+    auto inner = MakeShared<FVXRVersionedOctreeNode>();
+    inner->IsLeaf = false;
+
+    if ( InNode->IsLeaf ) {
+        // Split a full leaf: its samples move into fresh children that no other version references yet.
+        for ( auto& sample : InNode->Samples ) {
+            auto octant = VXROctreeOctant::GetOctant( InCenter, sample.Position );
+            inner->Children[octant] = InsertNode( inner->Children[octant], VXROctreeOctant::GetChildOrigin( InCenter, childExtent, octant ),
+                childExtent, InDepth + 1, sample );
+        }
+    }
+    else {
+        for ( int32 octant = 0; octant < 8; ++octant )
+            inner->Children[octant] = InNode->Children[octant];
+    }
+
+    auto octant = VXROctreeOctant::GetOctant( InCenter, InCameraData.Position );
+    inner->Children[octant] = InsertNode( inner->Children[octant], VXROctreeOctant::GetChildOrigin( InCenter, childExtent, octant ), childExtent,
+        InDepth + 1, InCameraData );
+    return inner;
+}
+
+FVXRVersionedOctreeSpatialIndex::FNodePtr FVXRVersionedOctreeSpatialIndex::RemoveNode( const FNodePtr& InNode, const FVector& InCenter,
+    const FVector& InExtent, const FVector& InPosition ) const
+{
+    if ( InNode->IsLeaf ) {
+        auto index = InNode->Samples.IndexOfByPredicate( [&InPosition]( const FVXRCameraData& InData ){ return InData.Position == InPosition; } );
+        if ( InNode->Samples.Num() == 1 && index == 0 )
+            return nullptr;
+
+        auto leaf = MakeShared<FVXRVersionedOctreeNode>( *InNode );
+        if ( index != INDEX_NONE )
+            leaf->Samples.RemoveAt( index );
+        return leaf;
+    }
+
+    auto octant = VXROctreeOctant::GetOctant( InCenter, InPosition );
+    auto inner = MakeShared<FVXRVersionedOctreeNode>( *InNode );
+    auto childExtent = InExtent * 0.5f;
+    inner->Children[octant] = RemoveNode( InNode->Children[octant], VXROctreeOctant::GetChildOrigin( InCenter, childExtent, octant ), childExtent, InPosition );
+
+    for ( auto& child : inner->Children ) {
+        if ( child.IsValid() )
+            return inner;
+    }
+
+    return nullptr;
+}
+
+void FVXRVersionedOctreeSpatialIndex::PushUndo()
+{
+    RedoStack.Reset();
+    if ( EditGroupDepth > 0 ) {
+        if ( EditGroupPushed )
+            return;
+        EditGroupPushed = true;
+    }
+
+    if ( MaxHistory == 0 )
+        return;
+
+    if ( UndoStack.Num() >= MaxHistory )
+        UndoStack.RemoveAt( 0 );
+    UndoStack.Add( Current );
+}
+
+bool FVXRVersionedOctreeSpatialIndex::Insert( const FVXRCameraData& InCameraData )
+{
+    if ( !FBox::BuildAABB( Origin, Extent ).IsInsideOrOn( InCameraData.Position ) )
+        return false;
+
+    PushUndo();
+    Current.Root = InsertNode( Current.Root, Origin, Extent, 0, InCameraData );
+    ++Current.Count;
+    return true;
+}
+
+bool FVXRVersionedOctreeSpatialIndex::Remove( const FVector& InPosition, float InTolerance )
+{
+    FVXRCameraData closest;
+    if ( FindNearest( InPosition, &closest, 1 ) == 0 || FVector::DistSquared( InPosition, closest.Position ) > FMath::Square( InTolerance ) )
+        return false;
+
+    PushUndo();
+    Current.Root = RemoveNode( Current.Root, Origin, Extent, closest.Position );
+    --Current.Count;
+    return true;
+}
+
+int32 FVXRVersionedOctreeSpatialIndex::FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const
+{
+    if ( !Current.Root.IsValid() || InCount <= 0 )
+        return 0;
+
+    FNearestList nearest;
+    SearchNearest( *Current.Root, Origin, Extent, InPosition, InCount, nearest );
+
+    for ( int32 i = 0; i < nearest.Num(); ++i )
+        OutCameraDatas[i] = nearest[i].Value;
+
+    return nearest.Num();
+}
+
+void FVXRVersionedOctreeSpatialIndex::QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( Current.Root.IsValid() )
+        SearchBox( *Current.Root, Origin, Extent, InBox, OutCameraDatas );
+}
+
+void FVXRVersionedOctreeSpatialIndex::GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const
+{
+    if ( !Current.Root.IsValid() )
+        return;
+
+    OutCameraDatas.Reserve( OutCameraDatas.Num() + Current.Count );
+    ForEachLeaf( *Current.Root, Origin, Extent, [&OutCameraDatas]( const FVXRVersionedOctreeNode& InLeaf, const FVector&, const FVector& ){
+            OutCameraDatas.Append( InLeaf.Samples );
+        } );
+}
+
+void FVXRVersionedOctreeSpatialIndex::GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const
+{
+    if ( !Current.Root.IsValid() )
+        return;
+
+    ForEachLeaf( *Current.Root, Origin, Extent, [&OutBlocks]( const FVXRVersionedOctreeNode& InLeaf, const FVector& InCenter, const FVector& InExtent ){
+            auto& block = OutBlocks.AddDefaulted_GetRef();
+            block.Origin = InCenter;
+            block.Extent = InExtent;
+            for ( auto& sample : InLeaf.Samples )
+                block.Samples.Add( FVXRPackedSample::Encode( sample.Position, sample.OffsetYaw, sample.OffsetPitch, InCenter, InExtent ) );
+        } );
+}
+
+int32 FVXRVersionedOctreeSpatialIndex::Num() const
+{
+    return Current.Count;
+}
+
+const TCHAR* FVXRVersionedOctreeSpatialIndex::GetName() const
+{
+    return TEXT( "VersionedOctree" );
+}
+
+bool FVXRVersionedOctreeSpatialIndex::Undo()
+{
+    if ( UndoStack.Num() == 0 )
+        return false;
+
+    RedoStack.Add( Current );
+    Current = UndoStack.Pop( false );
+    return true;
+}
+
+bool FVXRVersionedOctreeSpatialIndex::Redo()
+{
+    if ( RedoStack.Num() == 0 )
+        return false;
+
+    UndoStack.Add( Current );
+    Current = RedoStack.Pop( false );
+    return true;
+}
+
+bool FVXRVersionedOctreeSpatialIndex::CanUndo() const
+{
+    return UndoStack.Num() > 0;
+}
+
+bool FVXRVersionedOctreeSpatialIndex::CanRedo() const
+{
+    return RedoStack.Num() > 0;
+}
+
+void FVXRVersionedOctreeSpatialIndex::BeginEditGroup()
+{
+    if ( EditGroupDepth++ == 0 )
+        EditGroupPushed = false;
+}
+
+void FVXRVersionedOctreeSpatialIndex::EndEditGroup()
+{
+    if ( ensure( EditGroupDepth > 0 ) )
+        --EditGroupDepth;
+}
+
+void FVXRVersionedOctreeSpatialIndex::SaveVersion( FName InName )
+{
+    NamedVersions.Add( InName, Current );
+    VXR_LOG( Log, TEXT( "#### Save calibration version. Name:[%s] Samples:[%d] ####" ), *InName.ToString(), Current.Count );
+}
+
+bool FVXRVersionedOctreeSpatialIndex::SwitchVersion( FName InName )
+{
+    auto version = NamedVersions.Find( InName );
+    if ( version == nullptr )
+        return false;
+
+    PushUndo();
+    Current = *version;
+    VXR_LOG( Log, TEXT( "#### Switch calibration version. Name:[%s] Samples:[%d] ####" ), *InName.ToString(), Current.Count );
+    return true;
+}
+
+bool FVXRVersionedOctreeSpatialIndex::RemoveVersion( FName InName )
+{
+    return NamedVersions.Remove( InName ) > 0;
+}
+
+void FVXRVersionedOctreeSpatialIndex::GetVersionNames( TArray<FName>& OutNames ) const
+{
+    NamedVersions.GetKeys( OutNames );
+}
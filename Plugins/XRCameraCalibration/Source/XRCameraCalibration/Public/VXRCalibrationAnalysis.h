@@ -0,0 +1,93 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "VXRCameraData.h"
+#include "VXRCalibrationAnalysis.generated.h"
+
+USTRUCT( BlueprintType )
+struct XRCAMERACALIBRATION_API FVXRCoverageCell
+{
+    GENERATED_USTRUCT_BODY()
+    FVXRCoverageCell() = default;
+
+    //-------------------------------------------------------------------------
+
+    UPROPERTY( BlueprintReadOnly )
+    FIntVector Key = FIntVector::ZeroValue;
+    UPROPERTY( BlueprintReadOnly )
+    FVector Center = FVector::ZeroVector;
+    // Zero for an empty cell next to an occupied one, i.e. a coverage gap.
+    UPROPERTY( BlueprintReadOnly )
+    int32 SampleCount = 0;
+    // Leave-one-out rotation error in degrees.
+    UPROPERTY( BlueprintReadOnly )
+    float MeanError = 0.0f;
+    UPROPERTY( BlueprintReadOnly )
+    float MaxError = 0.0f;
+};
+
+USTRUCT( BlueprintType )
+struct XRCAMERACALIBRATION_API FVXRCalibrationSuggestion
+{
+    GENERATED_USTRUCT_BODY()
+    FVXRCalibrationSuggestion() = default;
+
+    //-------------------------------------------------------------------------
+
+    // Halfway between the worst sample of the cell and its two nearest neighbours, where the
+    // interpolation has the least support.
+    UPROPERTY( BlueprintReadOnly )
+    FVector Position = FVector::ZeroVector;
+    // Mean leave-one-out error of the cell, independent of how many samples it already holds.
+    UPROPERTY( BlueprintReadOnly )
+    float Score = 0.0f;
+    UPROPERTY( BlueprintReadOnly )
+    int32 CellIndex = INDEX_NONE;
+};
+
+USTRUCT( BlueprintType )
+struct XRCAMERACALIBRATION_API FVXRCalibrationAnalysisResult
+{
+    GENERATED_USTRUCT_BODY()
+    FVXRCalibrationAnalysisResult() = default;
+
+    //-------------------------------------------------------------------------
+
+    UPROPERTY( BlueprintReadOnly )
+    int32 SampleCount = 0;
+    // Samples whose error could not be evaluated (fewer than two other samples).
+    UPROPERTY( BlueprintReadOnly )
+    int32 SkippedCount = 0;
+    UPROPERTY( BlueprintReadOnly )
+    float MeanError = 0.0f;
+    UPROPERTY( BlueprintReadOnly )
+    float MaxError = 0.0f;
+    UPROPERTY( BlueprintReadOnly )
+    float CellSize = 0.0f;
+    // Occupied cells and the empty cells next to them, inside the bounds of the samples.
+    UPROPERTY( BlueprintReadOnly )
+    TArray<FVXRCoverageCell> Cells;
+    UPROPERTY( BlueprintReadOnly )
+    int32 EmptyCellCount = 0;
+    // Highest score first.
+    UPROPERTY( BlueprintReadOnly )
+    TArray<FVXRCalibrationSuggestion> Suggestions;
+    UPROPERTY( BlueprintReadOnly )
+    float ElapsedSeconds = 0.0f;
+};
+
+//-----------------------------------------------------------------------------
+
+// Evaluates how well the calibration predicts itself: every sample is removed in turn, its rotation is
+// interpolated from its two nearest neighbours like at runtime, and the difference to the stored offsets
+// is its error. Errors are accumulated in a sparse grid of InCellSize cells; the worst cells by mean error
+// are reported as suggestions. Runs on the calling thread and
+// fans out with ParallelFor, so it is meant to be called from a worker thread for large sets.
+// Neighbours are the global nearest samples, as returned by a frozen index or the grid and compact backends.
+// The unfrozen actor octree only searches the leaf containing the query, so at runtime its neighbours, and
+// its error near leaf borders, can differ from what is reported here.
+namespace VXRCalibrationAnalysis
+{
+    XRCAMERACALIBRATION_API void Analyze( const TArray<FVXRCameraData>& InCameraDatas, float InCellSize, int32 InSuggestionCount, 
+        FVXRCalibrationAnalysisResult& OutResult );
+}
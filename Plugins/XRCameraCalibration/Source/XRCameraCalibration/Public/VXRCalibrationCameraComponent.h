@@ -0,0 +1,74 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "Components/ActorComponent.h"
+#include "Engine/EngineTypes.h"
+#include "VXROctreeController.h"
+#include "VXRCalibrationCameraComponent.generated.h"
+
+// Applies the calibration offset of an AVXROctreeController to a camera natively, in a configurable tick group
+// that runs right after the tracking update so the correction lands in the same frame.
+UCLASS( ClassGroup=(VXR), meta=(BlueprintSpawnableComponent) )
+class XRCAMERACALIBRATION_API UVXRCalibrationCameraComponent : public UActorComponent
+{
+    GENERATED_UCLASS_BODY()
+public:
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationCamera|Functions" )
+    void SetTrackedComponent( class USceneComponent* InTrackedComponent );
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationCamera|Functions" )
+    void SetCorrectedComponent( class USceneComponent* InCorrectedComponent );
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationCamera|Functions" )
+    void SetTrackingUpdateComponent( class UActorComponent* InTrackingUpdateComponent );
+
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationCamera|Functions" )
+    FRotator GetAppliedOffset() const;
+
+public:
+    virtual void TickComponent( float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction ) override;
+
+protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay( EEndPlayReason::Type InEndPlayReason ) override;
+
+private:
+    void ResolveComponents();
+    UActorComponent* ResolveComponentReference( const FComponentReference& InReference ) const;
+    void RestoreBaseRotation();
+
+public:
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXRCalibrationCamera|Properties" )
+    class AVXROctreeController* CalibrationController;
+    UPROPERTY( EditAnywhere, Category="VXRCalibrationCamera|Properties" )
+    TEnumAsByte<ETickingGroup> CorrectionTickGroup;
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXRCalibrationCamera|Properties" )
+    bool ApplyYaw;
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXRCalibrationCamera|Properties" )
+    bool ApplyPitch;
+
+    // Component whose world location is used for the calibration query. Defaults to the owner's camera component.
+    UPROPERTY( EditAnywhere, Category="VXRCalibrationCamera|Components", meta=(UseComponentPicker, AllowAnyActor) )
+    FComponentReference TrackedComponentReference;
+    // Component whose relative rotation receives the offset. Defaults to the tracked component.
+    UPROPERTY( EditAnywhere, Category="VXRCalibrationCamera|Components", meta=(UseComponentPicker, AllowAnyActor) )
+    FComponentReference CorrectedComponentReference;
+    // Optional component that writes the tracked transform (e.g. a Live Link controller); ticked before us.
+    UPROPERTY( EditAnywhere, Category="VXRCalibrationCamera|Components", meta=(UseComponentPicker, AllowAnyActor) )
+    FComponentReference TrackingUpdateComponentReference;
+
+    UPROPERTY( Transient, BlueprintReadOnly, Category="VXRCalibrationCamera|Stats" )
+    float LastCorrectionTimeMs;
+
+private:
+    // Resolved from the references above at BeginPlay unless set through the setters.
+    UPROPERTY( Transient )
+    class USceneComponent* TrackedComponent;
+    UPROPERTY( Transient )
+    class USceneComponent* CorrectedComponent;
+    UPROPERTY( Transient )
+    class UActorComponent* TrackingUpdateComponent;
+
+    FRotator BaseRotation;
+    FRotator LastWrittenRotation;
+    FRotator AppliedOffset;
+    bool HasWrittenRotation;
+    FVXRQueryCache QueryCache;
+};
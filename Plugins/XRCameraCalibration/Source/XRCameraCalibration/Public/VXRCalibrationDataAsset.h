@@ -0,0 +1,41 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "Engine/DataAsset.h"
+#include "Serialization/BulkData.h"
+#include "VXRCameraData.h"
+#include "VXRCalibrationDataAsset.generated.h"
+
+// Cooked calibration: a prebuilt FVXRStaticKdTree kept as raw bulk data. Loading it is a single copy of
+// the payload, no parsing and no tree construction. Created in the editor by importing a calibration file.
+UCLASS( BlueprintType )
+class XRCAMERACALIBRATION_API UVXRCalibrationDataAsset : public UDataAsset
+{
+    GENERATED_UCLASS_BODY()
+public:
+    // Builds the kd-tree from InCameraDatas and stores it in the bulk data.
+    void SetCameraDatas( const TArray<FVXRCameraData>& InCameraDatas );
+    bool CreateKdTree( class FVXRStaticKdTree& OutKdTree ) const;
+
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationDataAsset|Functions" )
+    int32 GetSampleCount() const;
+
+public:
+    virtual void Serialize( FArchive& Ar ) override;
+
+public:
+#if WITH_EDITORONLY_DATA
+    UPROPERTY( VisibleAnywhere, Category="VXRCalibrationDataAsset|Properties" )
+    FString SourceFilePath;
+#endif
+
+private:
+    UPROPERTY( VisibleAnywhere, Category="VXRCalibrationDataAsset|Properties" )
+    int32 SampleCount;
+    UPROPERTY( VisibleAnywhere, Category="VXRCalibrationDataAsset|Properties" )
+    int32 NodeCount;
+    // Layout of the serialized tree; assets with another layout are rejected at load and have to be reimported.
+    UPROPERTY()
+    int32 LayoutVersion;
+
+    FByteBulkData IndexBulkData;
+};
@@ -0,0 +1,27 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "HAL/PlatformMemory.h"
+
+class FVXRStaticKdTree;
+
+// Writes an FVXRStaticKdTree into a named shared memory segment using the layout of VXRCalibrationShm.h.
+// The segment is sized once for a fixed sample capacity and updated in place under a seqlock.
+class FVXRCalibrationPublisher
+{
+public:
+    ~FVXRCalibrationPublisher();
+
+    bool Open( const FString& InName, int32 InSampleCapacity );
+    void Close();
+    bool IsOpen() const;
+
+    bool Publish( const FVXRStaticKdTree& InKdTree, bool InTruncated );
+
+    int32 GetSampleCapacity() const;
+
+private:
+    FPlatformMemory::FSharedMemoryRegion* Region = nullptr;
+    int32 SampleCapacity = 0;
+    int32 NodeCapacity = 0;
+};
@@ -0,0 +1,73 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Containers/SparseArray.h"
+#include "VXROctreeController.h"
+#include "VXRCalibrationQueryService.generated.h"
+
+USTRUCT( BlueprintType )
+struct XRCAMERACALIBRATION_API FVXRCorrectionHandle
+{
+    GENERATED_USTRUCT_BODY()
+    FVXRCorrectionHandle() = default;
+
+    bool IsValid() const { return Index != INDEX_NONE; }
+
+    //-------------------------------------------------------------------------
+
+    int32 Index = INDEX_NONE;
+    uint32 Serial = 0;
+};
+
+//-----------------------------------------------------------------------------
+
+// Collects the correction requests of every camera during a frame and resolves them in one batch,
+// in parallel when the batch is large. Each requester keeps its own coherence cache. The batch is
+// resolved on the first GetCorrection of the frame, or at the end of the frame otherwise.
+UCLASS()
+class XRCAMERACALIBRATION_API UVXRCalibrationQueryService : public UWorldSubsystem, public FTickableGameObject
+{
+    GENERATED_BODY()
+public:
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationQueryService|Functions" )
+    FVXRCorrectionHandle RegisterRequester( class AVXROctreeController* InController );
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationQueryService|Functions" )
+    void UnregisterRequester( UPARAM(ref) FVXRCorrectionHandle& InHandle );
+
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationQueryService|Functions" )
+    bool SubmitRequest( const FVXRCorrectionHandle& InHandle, const FVector& InCameraPosition );
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationQueryService|Functions" )
+    bool GetCorrection( const FVXRCorrectionHandle& InHandle, FRotator& OutRotation );
+
+    UFUNCTION( BlueprintCallable, Category="VXRCalibrationQueryService|Functions" )
+    void ResolvePendingRequests();
+
+public:
+    virtual void Deinitialize() override;
+
+    virtual void Tick( float DeltaTime ) override;
+    virtual bool IsTickable() const override;
+    virtual TStatId GetStatId() const override;
+
+public:
+    static int32 ParallelThreshold;
+
+private:
+    struct FRequester
+    {
+        TWeakObjectPtr<class AVXROctreeController> Controller;
+        FVXRQueryCache Cache;
+        FVector Position;
+        FRotator Result;
+        uint32 Serial;
+        bool Pending;
+    };
+
+    FRequester* FindRequester( const FVXRCorrectionHandle& InHandle );
+
+private:
+    TSparseArray<FRequester> Requesters;
+    TArray<int32> PendingIndices;
+    uint32 NextSerial = 1;
+};
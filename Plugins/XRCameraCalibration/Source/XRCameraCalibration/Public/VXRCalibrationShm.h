@@ -0,0 +1,65 @@
+/* Copyright ViveStudios. All Rights Reserved. */
+/*
+ * Layout of the calibration table that AVXROctreeController publishes into a named shared memory
+ * segment. Plain C, no engine dependencies, so local processes (tracking bridge, compositor) can
+ * include it directly; see VXRCalibrationShmReader.h for the reader.
+ *
+ * The segment is position independent: the header stores byte offsets from the segment base.
+ * Nodes form an implicit kd-tree (children of i are 2i+1 and 2i+2, leaves have axis == -1) over
+ * samples stored contiguously in leaf order. The writer updates the segment in place under a
+ * seqlock: `sequence` is odd while an update is in progress and advances by two per snapshot.
+ */
+#ifndef VXR_CALIBRATION_SHM_H
+#define VXR_CALIBRATION_SHM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VXR_SHM_MAGIC              0x4D485856u /* 'VXHM' */
+#define VXR_SHM_VERSION            1u
+#define VXR_SHM_FLAG_TRUNCATED     0x1u        /* more samples than the segment capacity */
+
+typedef struct VXRShmNode
+{
+    float split_value;
+    int32_t axis;
+    int32_t begin;
+    int32_t count;
+} VXRShmNode;
+
+typedef struct VXRShmSample
+{
+    float position[3];
+    float offset_yaw;
+    float offset_pitch;
+} VXRShmSample;
+
+typedef struct VXRShmHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    volatile uint32_t sequence;
+    uint32_t flags;
+    uint64_t generation;
+    uint32_t sample_capacity;
+    uint32_t node_capacity;
+    uint32_t sample_count;
+    uint32_t node_count;
+    uint32_t nodes_offset;
+    uint32_t samples_offset;
+} VXRShmHeader;
+
+static inline uint64_t vxr_shm_segment_size( uint32_t sample_capacity, uint32_t node_capacity )
+{
+    return (uint64_t)sizeof( VXRShmHeader ) + (uint64_t)node_capacity * sizeof( VXRShmNode ) +
+        (uint64_t)sample_capacity * sizeof( VXRShmSample );
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VXR_CALIBRATION_SHM_H */
@@ -0,0 +1,314 @@
+/* Copyright ViveStudios. All Rights Reserved. */
+/*
+ * Header-only C reader for the calibration table published by AVXROctreeController
+ * (PublishSharedMemory). Maps the segment read-only and answers lookups directly from it,
+ * without copies or file I/O. Not used by the engine module itself.
+ *
+ *   VXRShmReader reader;
+ *   if ( vxr_shm_open( &reader, "VXRCalibration" ) == 0 ) {
+ *       float yaw, pitch;
+ *       if ( vxr_shm_query( &reader, x, y, z, &yaw, &pitch, NULL ) == VXR_SHM_OK ) { ... }
+ *       vxr_shm_close( &reader );
+ *   }
+ *
+ * On Windows the segment name is used as is, on POSIX systems it is opened as "/<name>".
+ */
+#ifndef VXR_CALIBRATION_SHM_READER_H
+#define VXR_CALIBRATION_SHM_READER_H
+
+#include "VXRCalibrationShm.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VXR_SHM_OK            0
+#define VXR_SHM_NOT_ENOUGH    1  /* fewer than two samples published */
+#define VXR_SHM_ERROR        -1  /* segment missing or invalid */
+#define VXR_SHM_BUSY         -2  /* writer kept updating during every retry */
+
+#define VXR_SHM_MAX_RETRIES   64
+#define VXR_SHM_MAX_DEPTH     48
+
+typedef struct VXRShmReader
+{
+    const uint8_t* base;
+    uint64_t size;
+#if defined(_WIN32)
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} VXRShmReader;
+
+static inline uint32_t vxr_shm_load_sequence( const volatile uint32_t* sequence )
+{
+#if defined(_MSC_VER)
+    uint32_t value = *sequence;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n( sequence, __ATOMIC_ACQUIRE );
+#endif
+}
+
+static inline void vxr_shm_read_fence( void )
+{
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+    MemoryBarrier();
+#else
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+#endif
+}
+
+static inline const VXRShmHeader* vxr_shm_header( const VXRShmReader* reader )
+{
+    return (const VXRShmHeader*)reader->base;
+}
+
+static inline int vxr_shm_validate( const VXRShmReader* reader )
+{
+    const VXRShmHeader* header = vxr_shm_header( reader );
+    if ( reader->size < sizeof( VXRShmHeader ) || header->magic != VXR_SHM_MAGIC || header->version != VXR_SHM_VERSION )
+        return 0;
+
+    if ( (uint64_t)header->nodes_offset + (uint64_t)header->node_capacity * sizeof( VXRShmNode ) > reader->size )
+        return 0;
+
+    if ( (uint64_t)header->samples_offset + (uint64_t)header->sample_capacity * sizeof( VXRShmSample ) > reader->size )
+        return 0;
+
+    return 1;
+}
+
+static inline void vxr_shm_close( VXRShmReader* reader )
+{
+#if defined(_WIN32)
+    if ( reader->base != NULL )
+        UnmapViewOfFile( reader->base );
+    if ( reader->mapping != NULL )
+        CloseHandle( reader->mapping );
+    reader->mapping = NULL;
+#else
+    if ( reader->base != NULL )
+        munmap( (void*)reader->base, (size_t)reader->size );
+    if ( reader->fd >= 0 )
+        close( reader->fd );
+    reader->fd = -1;
+#endif
+    reader->base = NULL;
+    reader->size = 0;
+}
+
+static inline int vxr_shm_open( VXRShmReader* reader, const char* name )
+{
+    reader->base = NULL;
+    reader->size = 0;
+#if defined(_WIN32)
+    MEMORY_BASIC_INFORMATION info;
+    reader->mapping = OpenFileMappingA( FILE_MAP_READ, FALSE, name );
+    if ( reader->mapping == NULL )
+        return VXR_SHM_ERROR;
+
+    reader->base = (const uint8_t*)MapViewOfFile( reader->mapping, FILE_MAP_READ, 0, 0, 0 );
+    if ( reader->base == NULL || VirtualQuery( reader->base, &info, sizeof( info ) ) == 0 ) {
+        vxr_shm_close( reader );
+        return VXR_SHM_ERROR;
+    }
+    reader->size = (uint64_t)info.RegionSize;
+#else
+    char path[256];
+    struct stat info;
+    void* address;
+    snprintf( path, sizeof( path ), "/%s", name );
+    reader->fd = shm_open( path, O_RDONLY, 0 );
+    if ( reader->fd < 0 )
+        return VXR_SHM_ERROR;
+
+    if ( fstat( reader->fd, &info ) != 0 || info.st_size <= 0 ) {
+        vxr_shm_close( reader );
+        return VXR_SHM_ERROR;
+    }
+
+    address = mmap( NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, reader->fd, 0 );
+    if ( address == MAP_FAILED ) {
+        vxr_shm_close( reader );
+        return VXR_SHM_ERROR;
+    }
+    reader->base = (const uint8_t*)address;
+    reader->size = (uint64_t)info.st_size;
+#endif
+
+    if ( !vxr_shm_validate( reader ) ) {
+        vxr_shm_close( reader );
+        return VXR_SHM_ERROR;
+    }
+
+    return VXR_SHM_OK;
+}
+
+/* Same interpolation as VXRCalibrationInterpolation::InterpolateRotatorComponent (VXRCalibrationInterpolation.h). */
+static inline float vxr_shm_interpolate( const float* camera, float value0, float value1, const float* position0,
+    const float* position1 )
+{
+    const float* min_pos = value0 < value1 ? position0 : position1;
+    const float* max_pos = value0 < value1 ? position1 : position0;
+    float min_value = value0 < value1 ? value0 : value1;
+    float max_value = value0 < value1 ? value1 : value0;
+    float direction[3], dir_size, proj_size;
+    int i;
+
+    for ( i = 0; i < 3; ++i )
+        direction[i] = max_pos[i] - min_pos[i];
+
+    dir_size = sqrtf( direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2] );
+    if ( dir_size <= 1e-8f ) /* SMALL_NUMBER */
+        return min_value;
+
+    proj_size = 0.0f;
+    for ( i = 0; i < 3; ++i )
+        proj_size += (camera[i] - min_pos[i]) * (direction[i] / dir_size);
+    proj_size = fabsf( proj_size );
+
+    if ( dir_size < proj_size )
+        return 0.0f;
+
+    return min_value + (max_value - min_value) * (proj_size / dir_size);
+}
+
+/* Two nearest samples over the kd-tree. Indices are bounds checked because a concurrent update
+ * can expose a torn table; the seqlock retry in vxr_shm_query discards such results. */
+static inline void vxr_shm_find_nearest( const VXRShmHeader* header, const VXRShmNode* nodes, const VXRShmSample* samples,
+    const float* position, int32_t* best_index, float* best_dist )
+{
+    int32_t stack[VXR_SHM_MAX_DEPTH * 2];
+    float stack_dist[VXR_SHM_MAX_DEPTH * 2];
+    int32_t stack_size = 0;
+    stack[stack_size] = 0;
+    stack_dist[stack_size++] = 0.0f;
+
+    while ( stack_size > 0 ) {
+        int32_t node_index;
+        const VXRShmNode* node;
+        --stack_size;
+        node_index = stack[stack_size];
+        if ( stack_dist[stack_size] >= best_dist[1] )
+            continue;
+        if ( node_index < 0 || (uint32_t)node_index >= header->node_count )
+            continue;
+
+        node = &nodes[node_index];
+        if ( node->axis < 0 ) {
+            int32_t i;
+            if ( node->begin < 0 || node->count < 0 || (uint32_t)(node->begin + node->count) > header->sample_count )
+                continue;
+
+            for ( i = node->begin; i < node->begin + node->count; ++i ) {
+                float dx = position[0] - samples[i].position[0];
+                float dy = position[1] - samples[i].position[1];
+                float dz = position[2] - samples[i].position[2];
+                float dist = dx * dx + dy * dy + dz * dz;
+                if ( dist < best_dist[0] ) {
+                    best_dist[1] = best_dist[0];
+                    best_index[1] = best_index[0];
+                    best_dist[0] = dist;
+                    best_index[0] = i;
+                }
+                else if ( dist < best_dist[1] ) {
+                    best_dist[1] = dist;
+                    best_index[1] = i;
+                }
+            }
+        }
+        else if ( node->axis <= 2 && stack_size + 2 <= VXR_SHM_MAX_DEPTH * 2 ) {
+            float diff = position[node->axis] - node->split_value;
+            /* Far side first so the near side is visited first; the far side is skipped on pop once
+             * the second best is closer than the split plane. */
+            stack[stack_size] = 2 * node_index + (diff < 0.0f ? 2 : 1);
+            stack_dist[stack_size++] = diff * diff;
+            stack[stack_size] = 2 * node_index + (diff < 0.0f ? 1 : 2);
+            stack_dist[stack_size++] = 0.0f;
+        }
+    }
+}
+
+/* Looks up the yaw/pitch correction at (x, y, z). out_generation, when not NULL, receives the
+ * snapshot generation the answer was computed from. */
+static inline int vxr_shm_query( const VXRShmReader* reader, float x, float y, float z, float* out_yaw, float* out_pitch,
+    uint64_t* out_generation )
+{
+    const VXRShmHeader* header;
+    const VXRShmNode* nodes;
+    const VXRShmSample* samples;
+    float position[3];
+    int retry;
+
+    if ( reader->base == NULL )
+        return VXR_SHM_ERROR;
+
+    header = vxr_shm_header( reader );
+    nodes = (const VXRShmNode*)(reader->base + header->nodes_offset);
+    samples = (const VXRShmSample*)(reader->base + header->samples_offset);
+    position[0] = x;
+    position[1] = y;
+    position[2] = z;
+
+    for ( retry = 0; retry < VXR_SHM_MAX_RETRIES; ++retry ) {
+        uint32_t begin_sequence = vxr_shm_load_sequence( &header->sequence );
+        int32_t best_index[2] = { -1, -1 };
+        float best_dist[2] = { INFINITY, INFINITY };
+        float yaw = 0.0f, pitch = 0.0f;
+        uint64_t generation;
+        int result = VXR_SHM_NOT_ENOUGH;
+
+        if ( begin_sequence & 1u )
+            continue;
+
+        vxr_shm_read_fence();
+        generation = header->generation;
+        if ( header->sample_count <= header->sample_capacity && header->node_count <= header->node_capacity ) {
+            vxr_shm_find_nearest( header, nodes, samples, position, best_index, best_dist );
+            if ( best_index[0] >= 0 && best_index[1] >= 0 ) {
+                const VXRShmSample* first = &samples[best_index[0]];
+                const VXRShmSample* second = &samples[best_index[1]];
+                yaw = vxr_shm_interpolate( position, first->offset_yaw, second->offset_yaw, first->position, second->position );
+                pitch = vxr_shm_interpolate( position, first->offset_pitch, second->offset_pitch, first->position,
+                    second->position );
+                result = VXR_SHM_OK;
+            }
+        }
+
+        vxr_shm_read_fence();
+        if ( vxr_shm_load_sequence( &header->sequence ) != begin_sequence )
+            continue;
+
+        if ( out_yaw != NULL )
+            *out_yaw = yaw;
+        if ( out_pitch != NULL )
+            *out_pitch = pitch;
+        if ( out_generation != NULL )
+            *out_generation = generation;
+        return result;
+    }
+
+    return VXR_SHM_BUSY;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VXR_CALIBRATION_SHM_READER_H */
@@ -0,0 +1,38 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "VXRCameraData.h"
+
+struct XRCAMERACALIBRATION_API FVXRTextParseReport
+{
+    int32 LineCount = 0;
+    int32 SampleCount = 0;
+    int32 MalformedLineCount = 0;
+    // 1-based line numbers of the first malformed lines, capped at MaxReportedLines.
+    TArray<int32> MalformedLines;
+
+    static const int32 MaxReportedLines = 16;
+};
+
+//-----------------------------------------------------------------------------
+
+// Codec for the legacy text format, one sample per line:
+//   OctreeElement[Position, Yaw, Pitch]:x,y,z,yaw,pitch
+// Parsing scans the raw file buffer in place and splits large files into newline-aligned chunks
+// that are parsed in parallel. Writing formats into one reused buffer.
+class XRCAMERACALIBRATION_API FVXRCalibrationTextCodec
+{
+public:
+    bool LoadFile( const FString& InFilePath, TArray<FVXRCameraData>& OutCameraDatas, FVXRTextParseReport& OutReport );
+    bool SaveFile( const FString& InFilePath, const TArray<FVXRCameraData>& InCameraDatas );
+
+    void Parse( const FString& InText, TArray<FVXRCameraData>& OutCameraDatas, FVXRTextParseReport& OutReport );
+    const FString& Write( const TArray<FVXRCameraData>& InCameraDatas );
+
+public:
+    static const TCHAR* LinePrefix;
+    static int32 ChunkSize;
+
+private:
+    FString WriteBuffer;
+};
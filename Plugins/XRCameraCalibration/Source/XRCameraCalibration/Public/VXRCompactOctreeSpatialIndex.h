@@ -0,0 +1,33 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "VXRSpatialIndex.h"
+
+template<int32 LeafCapacity, typename PayloadType>
+class TVXROctree;
+
+// Spatial index over TVXROctree<16, FVXRCameraData>: one flat node array with inline leaf storage,
+// no actors. Nearest queries are global, not limited to the first matching leaf.
+class XRCAMERACALIBRATION_API FVXRCompactOctreeSpatialIndex : public IVXRSpatialIndex
+{
+public:
+    FVXRCompactOctreeSpatialIndex( const FVector& InOrigin, const FVector& InExtent, int32 InMaxDepth );
+    virtual ~FVXRCompactOctreeSpatialIndex();
+
+    virtual bool Insert( const FVXRCameraData& InCameraData ) override;
+    virtual bool Remove( const FVector& InPosition, float InTolerance ) override;
+
+    virtual int32 FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const override;
+    virtual void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const override;
+
+    virtual void GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const override;
+    virtual void GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const override;
+    virtual int32 Num() const override;
+
+    virtual const TCHAR* GetName() const override;
+
+public:
+    static const int32 LeafCapacity = 16;
+
+private:
+    TUniquePtr<TVXROctree<LeafCapacity, FVXRCameraData>> Octree;
+};
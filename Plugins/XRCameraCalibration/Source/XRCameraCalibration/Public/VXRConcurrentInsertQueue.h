@@ -0,0 +1,34 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "VXRCameraData.h"
+
+class IVXRSpatialIndex;
+
+// Multi-writer staging area in front of a spatial index. Capture threads enqueue samples lock-free into
+// one MPSC queue; the owning thread drains them into the index in bounded batches. The queue holds at
+// most Capacity samples, further enqueues fail until the owning thread catches up.
+class XRCAMERACALIBRATION_API FVXRConcurrentInsertQueue
+{
+public:
+    explicit FVXRConcurrentInsertQueue( int32 InCapacity = 4096 );
+
+    // Any thread. Returns false, and drops the sample, when the queue is full.
+    bool Enqueue( const FVXRCameraData& InCameraData );
+    int32 GetPendingCount() const;
+
+    // Owning thread only, while no thread enqueues.
+    void SetCapacity( int32 InCapacity );
+    // Owning thread only. Dequeues at most InMaxCount samples and returns how many the index accepted;
+    // OutRejectedCount receives how many it refused.
+    int32 Drain( IVXRSpatialIndex& InIndex, int32 InMaxCount, int32& OutRejectedCount );
+    // Owning thread only. Drops every queued sample and returns how many were dropped.
+    int32 Reset();
+
+private:
+    TQueue<FVXRCameraData, EQueueMode::Mpsc> Queue;
+    FThreadSafeCounter PendingCount;
+    int32 Capacity;
+};
@@ -0,0 +1,32 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "VXRCameraData.h"
+
+enum class EVXRElementDataChangeType : uint8
+{
+    Insert,
+    Remove,
+    // Same position key, different offsets: removed then inserted again.
+    Update
+};
+
+struct FVXRElementDataChange
+{
+    FVXRCameraData CameraData;
+    // Live sample of the snapshot the change was made against (Remove and Update).
+    FVXRCameraData LiveCameraData;
+    EVXRElementDataChangeType Type;
+};
+
+//-----------------------------------------------------------------------------
+
+// Difference between the live calibration and a newly loaded sample set. Samples are matched by their
+// position quantized to InKeyResolution, so only real edits produce changes. Pure function, safe on any thread.
+namespace VXRElementDataDiff
+{
+    XRCAMERACALIBRATION_API FIntVector GetPositionKey( const FVector& InPosition, float InKeyResolution );
+
+    XRCAMERACALIBRATION_API void Diff( const TArray<FVXRCameraData>& InLiveDatas, const TArray<FVXRCameraData>& InNewDatas, 
+        float InKeyResolution, TArray<FVXRElementDataChange>& OutChanges );
+}
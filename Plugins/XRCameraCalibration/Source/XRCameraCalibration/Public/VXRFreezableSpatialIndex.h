@@ -0,0 +1,44 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "VXRSpatialIndex.h"
+#include "VXRStaticKdTree.h"
+
+// Wraps a dynamic spatial index and can freeze its content into an FVXRStaticKdTree. While frozen,
+// every query is answered by the kd-tree; any edit thaws back to the dynamic index first, and is
+// rejected when the dynamic index cannot take back every frozen sample.
+class XRCAMERACALIBRATION_API FVXRFreezableSpatialIndex : public IVXRSpatialIndex
+{
+public:
+    explicit FVXRFreezableSpatialIndex( TUniquePtr<IVXRSpatialIndex>&& InDynamicIndex );
+
+    void Freeze();
+    // Freezes with a prebuilt kd-tree, e.g. from a cooked asset. It replaces the dynamic content, the dynamic
+    // index is filled from it on the next thaw.
+    void Freeze( FVXRStaticKdTree&& InKdTree );
+    // Fails, and stays frozen, if the dynamic index rejects any sample of a prebuilt tree. The failure is
+    // kept until the next freeze, so repeated edits do not refill the dynamic index again.
+    bool Thaw();
+    bool IsFrozen() const;
+
+    IVXRSpatialIndex* GetDynamicIndex() const;
+    const FVXRStaticKdTree& GetFrozenIndex() const;
+
+    virtual bool Insert( const FVXRCameraData& InCameraData ) override;
+    virtual bool Remove( const FVector& InPosition, float InTolerance ) override;
+
+    virtual int32 FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const override;
+    virtual void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const override;
+
+    virtual void GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const override;
+    virtual void GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const override;
+    virtual int32 Num() const override;
+
+    virtual const TCHAR* GetName() const override;
+
+private:
+    TUniquePtr<IVXRSpatialIndex> DynamicIndex;
+    FVXRStaticKdTree FrozenIndex;
+    bool Frozen;
+    bool DynamicIndexStale;
+    bool ThawFailed;
+};
@@ -0,0 +1,37 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "VXRSpatialIndex.h"
+
+// Sparse uniform voxel grid keyed by integer cell coordinates. Cell lookup is a single hash probe
+// and each cell keeps its samples packed contiguously, quantized against the cell bounds.
+class XRCAMERACALIBRATION_API FVXRHashGridSpatialIndex : public IVXRSpatialIndex
+{
+public:
+    explicit FVXRHashGridSpatialIndex( float InCellSize );
+
+    virtual bool Insert( const FVXRCameraData& InCameraData ) override;
+    virtual bool Remove( const FVector& InPosition, float InTolerance ) override;
+
+    virtual int32 FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const override;
+    virtual void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const override;
+
+    virtual void GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const override;
+    virtual void GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const override;
+    virtual int32 Num() const override;
+
+    virtual const TCHAR* GetName() const override;
+
+    float GetCellSize() const;
+
+private:
+    FIntVector GetCellKey( const FVector& InPosition ) const;
+    FVector GetCellOrigin( const FIntVector& InKey ) const;
+    FVector GetCellExtent() const;
+
+private:
+    float CellSize;
+    int32 SampleCount;
+    FIntVector MinKey;
+    FIntVector MaxKey;
+    TMap<FIntVector, TArray<FVXRPackedSample>> Cells;
+};
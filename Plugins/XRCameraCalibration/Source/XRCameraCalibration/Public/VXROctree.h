@@ -1,7 +1,9 @@
 // Copyright ViveStudios. All Rights Reserved.
 #pragma once
 #include "VXRCameraData.h"
+#include "VXRPackedSample.h"
 #include "GameFramework/Actor.h"
+#include "ConvexVolume.h"
 #include "VXROctree.generated.h"
 
 UCLASS()
@@ -12,12 +14,14 @@ public:
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions", meta=(WorldContext="InWorldContextObject", AdvancedDisplay=6) )
     static AVXROctree* SpawnRootOctree( UObject* InWorldContextObject, const FVector& InOrigin, const FVector& InExtent, 
         TSubclassOf<class AVXROctreeElement> InElementClass, int32 InMaxElements, int32 InMaxDepth, float InDrawLifeTime = 0.1f, 
-        FColor InNodeColor = FColor::Blue );
+        FColor InNodeColor = FColor::Blue, bool InSpawnElementActors = false, bool InKeepExactSamples = false );
 
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
     bool InsertPositionInOctree( const FVector& InPosition );
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
     bool InsertElementInOctree( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch );
+    UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
+    bool RemoveElementInOctree( const FVector& InPosition, float InTolerance );
 
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
     class AVXROctree* FindNode( const FVector& InPosition );
@@ -31,12 +35,26 @@ public:
 
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
     void GetElementDatas( TArray<FString>& OutElementDatas );
+    UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
+    void GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const;
+
+    // Range queries append to OutCameraDatas. Subtrees outside the range are skipped and nodes fully
+    // inside it are appended without per-sample tests.
+    UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
+    void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const;
+    UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
+    void QuerySphere( const FVector& InCenter, float InRadius, TArray<FVXRCameraData>& OutCameraDatas ) const;
 
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
     FVector GetBoundingBoxOrigin() const;
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
     FVector GetBoundingBoxExtent() const;
 
+    UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
+    int32 GetElementCount() const;
+    UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
+    void DestroyOctree();
+
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
     void PrintDebugNode();
     UFUNCTION( BlueprintCallable, Category="VXROctree|Functions" )
@@ -45,9 +63,15 @@ public:
     void DrawDebugElement();
 
 public:
-    bool IsInNodeRange( const FVector& InObjectPos );
+    bool IsInNodeRange( const FVector& InObjectPos ) const;
     bool IsLeafNode() const;
 
+    // Up to InCount nearest samples, closest first, in the first leaf containing InPosition. Decoded from the packed leaf storage.
+    int32 FindNearestSamples( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const;
+    void QueryFrustum( const FConvexVolume& InFrustum, TArray<FVXRCameraData>& OutCameraDatas ) const;
+    void GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const;
+    FBox GetNodeBox() const;
+
 private:
     void Init( const FVector& InOrigin, const FVector& InExtent, int32 InDepth, TSubclassOf<class AVXROctreeElement> InElementClass, 
         AVXROctree* InParentNode );
@@ -57,13 +81,21 @@ private:
     bool InsertChildrenTree( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch );
     class AVXROctree* FindNodeFromChildrenTree( const FVector& InPosition );
     class AVXROctreeElement* FindElementFromChildrenTree( const FVector& InPosition, const class AVXROctreeElement* InHasElement );
+    const AVXROctree* FindSampleLeaf( const FVector& InPosition ) const;
+    void FindClosestSample( const FVector& InPosition, float& InOutDistSq, AVXROctree*& OutNode, int32& OutIndex );
+    void RemoveSampleAt( int32 InIndex );
+    FVector GetSamplePosition( int32 InIndex ) const;
+    FVXRCameraData GetSample( int32 InIndex ) const;
+    void QuerySphereSquared( const FVector& InCenter, float InRadiusSq, TArray<FVXRCameraData>& OutCameraDatas ) const;
 
     bool SpawnOctree( const FVector& InSpawnLocation, const FVector& InSpawnExtent, int32 InDpeth );
     bool SpawnElement( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch );
+    void AddExactSample( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch );
 
     void SetBoundingBox( const FVector& InOrigin, const FVector& InExtent, int32 InDepth );
 
     void DrawNode( const FVector& InOrigin, const FVector& InExtent );
+    void DrawPackedSamples();
     void PrintNode();
 
 protected:
@@ -71,6 +103,8 @@ protected:
     static int32 MaxElements;
     static float DrawLifeTime;
     static FColor NodeColor;
+    static bool SpawnElementActors;
+    static bool KeepExactSamples;
 
 protected:
     struct FNode
@@ -92,4 +126,10 @@ protected:
     AVXROctree* ParentTree;
     UPROPERTY( transient )
     TArray<AVXROctree*> ChildrenTree;
+
+    // Authoritative sample storage of the node, quantized against BoundingBox. ElementList only
+    // mirrors it with actors when SpawnElementActors is set.
+    TArray<FVXRPackedSample> PackedSamples;
+    // Full precision copy of PackedSamples, only kept when KeepExactSamples is set (text element data).
+    TArray<FVXRCameraData> ExactSamples;
 };
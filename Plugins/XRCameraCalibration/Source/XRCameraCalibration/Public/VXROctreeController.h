@@ -1,8 +1,35 @@
 // Copyright ViveStudios. All Rights Reserved.
 #pragma once
 #include "GameFramework/Actor.h"
+#include "VXRCalibrationTextCodec.h"
+#include "VXRFreezableSpatialIndex.h"
+#include "VXRCalibrationPublisher.h"
+#include "VXRElementDataDiff.h"
+#include "VXRConcurrentInsertQueue.h"
+#include "VXRCalibrationAnalysis.h"
 #include "VXROctreeController.generated.h"
 
+UENUM( BlueprintType )
+enum class EVXRElementDataFormat : uint8
+{
+    Text,
+    Packed
+};
+
+// Per-requester query state, so several cameras sharing one controller do not evict each other's cached node.
+struct FVXRQueryCache
+{
+    class AVXROctree* Node = nullptr;
+    FVector Position = FVector::ZeroVector;
+    FRotator Result = FRotator::ZeroRotator;
+    uint32 IndexRevision = 0;
+    bool Valid = false;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam( FVXRCalibrationAnalyzedSignature, const FVXRCalibrationAnalysisResult&, Result );
+
+//-----------------------------------------------------------------------------
+
 UCLASS()
 class XRCAMERACALIBRATION_API AVXROctreeController : public AActor
 {
@@ -17,12 +44,60 @@ public:
     bool FindOctreeNode( const FVector& InCameraPosition );
     UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
     bool InsertToOctree( const FVector& InCameraPosition );
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool RemoveFromOctree( const FVector& InCameraPosition, float InTolerance = 1.0f );
+
+    // Freezes the calibration into a static kd-tree for read-only use. Any insert or remove thaws it again.
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    void FreezeIndex();
+    // Returns false, and the index stays frozen, if the dynamic backend cannot hold every frozen sample.
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool ThawIndex();
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool IsIndexFrozen() const;
+
+    // Versioned octree only. Undo/redo also cover removes and version switches.
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool Undo();
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool Redo();
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool SaveCalibrationVersion( FName InVersionName );
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool SwitchCalibrationVersion( FName InVersionName );
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    void GetCalibrationVersionNames( TArray<FName>& OutVersionNames ) const;
 
     UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
     void SaveOctreeElementDatas();
     UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
     void LoadOctreeElementDatas();
 
+    // Runs the leave-one-out coverage/error analysis on a worker thread; OnCalibrationAnalyzed fires when done.
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    bool StartCalibrationAnalysis();
+    UFUNCTION( BlueprintCallable, Category="VXROctreeController|Functions" )
+    void DrawCalibrationAnalysis( float InLifeTime = 10.0f ) const;
+
+public:
+    IVXRSpatialIndex* GetSpatialIndex() const;
+    uint32 GetIndexRevision() const;
+
+    // Callable from any thread (e.g. device input threads) between BeginPlay and EndPlay. The sample is
+    // queued without locking and inserted on the game thread over the next ticks, ConcurrentInsertBatchSize per frame.
+    // Returns false when the queue already holds ConcurrentInsertCapacity samples; the caller should back off.
+    bool InsertToOctreeThreadSafe( const FVXRCameraData& InCameraData );
+
+    // Read-only lookup that keeps its coherence state in InOutCache instead of CurrentOctree.
+    // Safe to call from worker threads as long as the index is not edited at the same time.
+    FRotator GetCollectCameraRotation( const FVector& InCameraPosition, FVXRQueryCache& InOutCache ) const;
+
+    static FRotator InterpolateCameraRotation( const FVector& InCameraPosition, const FVXRCameraData& InFirst, 
+        const FVXRCameraData& InSecond );
+
+public:
+    virtual void Tick( float DeltaSeconds ) override;
+
 protected:
     virtual void BeginPlay() override;
     virtual void EndPlay( EEndPlayReason::Type InEndPlayReason ) override;
@@ -30,8 +105,22 @@ protected:
     bool InsertPositionInOctree( const FVector& InCameraPosition );
     bool InsertElementInOctree( const FVector& InCameraPosition, float InOffsetYaw, float InOffsetPitch );
 
+    FString GetElementDataFilePath() const;
+
+    void CreateSpatialIndex();
+    void LoadCalibrationAsset();
+
+    void StartElementDataReload();
+    void FinishElementDataReload( TArray<FVXRElementDataChange>&& InChanges );
+    void ApplyElementDataChanges();
+    void OnElementDataDirectoryChanged( const TArray<struct FFileChangeData>& InFileChanges );
+
+    void DrainConcurrentInserts();
+    void MarkIndexChanged();
+    void PublishSharedMemoryTable();
+
 private:
-    float GetCollectCameraRotatorComponent( const FVector& InCameraPosition, float InRotComp0, float InRotComp1, 
+    static float GetCollectCameraRotatorComponent( const FVector& InCameraPosition, float InRotComp0, float InRotComp1, 
         const FVector& InElementPos0, const FVector& InElementPos1, const FColor& InColor );
 
 public:
@@ -42,6 +131,16 @@ public:
     UPROPERTY( EditInstanceOnly, BlueprintReadWrite, Category="VXROctreeController|Operator" )
     float OffsetPitch;
 
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
+    EVXRSpatialIndexType SpatialIndexType;
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties", meta=(EditCondition="SpatialIndexType==EVXRSpatialIndexType::HashGrid") )
+    float GridCellSize;
+    // Depth of the compact octree; full leaves at this depth keep growing instead of rejecting samples.
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties", meta=(EditCondition="SpatialIndexType==EVXRSpatialIndexType::CompactOctree", ClampMin="1", ClampMax="16") )
+    int32 CompactOctreeMaxDepth;
+    // Depth of the versioned octree; full leaves at this depth keep growing instead of splitting.
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties", meta=(EditCondition="SpatialIndexType==EVXRSpatialIndexType::VersionedOctree", ClampMin="1", ClampMax="16") )
+    int32 VersionedOctreeMaxDepth;
     UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
     FVector Extent;
     UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
@@ -51,6 +150,8 @@ public:
     UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
     int32 MaxElements;
     UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
+    bool SpawnElementActors;
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
     bool UseDebugDraw;
     UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
     FColor NodeColor;
@@ -61,13 +162,81 @@ public:
     FDirectoryPath ElementDataPath;
     UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
     FString ElementDataFilename;
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties" )
+    EVXRElementDataFormat ElementDataFormat;
+    // Cooked calibration loaded at BeginPlay as a frozen index, without parsing or tree construction.
+    UPROPERTY( EditAnywhere, BlueprintReadOnly, Category="VXROctreeController|Properties" )
+    class UVXRCalibrationDataAsset* CalibrationAsset;
+
+    // Watches ElementDataPath and applies only the differences of a changed element data file (non-shipping builds).
+    UPROPERTY( EditAnywhere, BlueprintReadOnly, Category="VXROctreeController|HotReload" )
+    bool HotReloadElementData;
+    // Inserts/removes applied per frame while a reload is pending.
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|HotReload", meta=(ClampMin="1") )
+    int32 HotReloadBatchSize;
+    // Samples closer than this match the same position key when diffing.
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|HotReload", meta=(ClampMin="0.001") )
+    float HotReloadKeyResolution;
+
+    // Samples queued by InsertToOctreeThreadSafe that are inserted per frame.
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties", meta=(ClampMin="1") )
+    int32 ConcurrentInsertBatchSize;
+    // Samples InsertToOctreeThreadSafe can queue ahead of the game thread before it starts refusing them.
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Properties", meta=(ClampMin="1") )
+    int32 ConcurrentInsertCapacity;
+
+    // Publishes the calibration table to a named shared memory segment for local processes (see VXRCalibrationShmReader.h).
+    UPROPERTY( EditAnywhere, BlueprintReadOnly, Category="VXROctreeController|SharedMemory" )
+    bool PublishSharedMemory;
+    UPROPERTY( EditAnywhere, BlueprintReadOnly, Category="VXROctreeController|SharedMemory", meta=(EditCondition="PublishSharedMemory") )
+    FString SharedMemoryName;
+    // Fixed sample capacity of the segment. Larger tables are published subsampled with the truncated flag set.
+    UPROPERTY( EditAnywhere, BlueprintReadOnly, Category="VXROctreeController|SharedMemory", meta=(EditCondition="PublishSharedMemory", ClampMin="2") )
+    int32 SharedMemoryCapacity;
+
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Analysis", meta=(ClampMin="1.0") )
+    float AnalysisCellSize;
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Analysis", meta=(ClampMin="0") )
+    int32 AnalysisSuggestionCount;
+    // Mean cell error drawn fully red by DrawCalibrationAnalysis.
+    UPROPERTY( EditAnywhere, BlueprintReadWrite, Category="VXROctreeController|Analysis", meta=(ClampMin="0.001") )
+    float AnalysisErrorScale;
+
+    UPROPERTY( BlueprintAssignable, Category="VXROctreeController|Analysis" )
+    FVXRCalibrationAnalyzedSignature OnCalibrationAnalyzed;
 
 public:
     UPROPERTY( Transient, BlueprintReadOnly )
     class AVXROctree* RootOctree;
     UPROPERTY( Transient, BlueprintReadOnly )
     class AVXROctree* CurrentOctree;
+    UPROPERTY( Transient, BlueprintReadOnly )
+    int32 LastMalformedLineCount;
+    UPROPERTY( Transient, BlueprintReadOnly )
+    FVXRCalibrationAnalysisResult LastAnalysisResult;
 
 private:
     FTimerHandle DebugDrawHandle;
+    FVXRCalibrationTextCodec TextCodec;
+    TUniquePtr<FVXRFreezableSpatialIndex> SpatialIndex;
+    // Set when SpatialIndexType is VersionedOctree, owned by SpatialIndex.
+    class FVXRVersionedOctreeSpatialIndex* VersionedIndex;
+    uint32 IndexRevision;
+
+    FVXRCalibrationPublisher Publisher;
+    FVXRStaticKdTree PublishedKdTree;
+    TArray<FVXRCameraData> PublishScratch;
+    bool PublishPending;
+
+    FDelegateHandle ElementDataWatchHandle;
+    FString WatchedDirectory;
+    TArray<FVXRElementDataChange> PendingChanges;
+    int32 PendingChangeIndex;
+    bool ReloadInProgress;
+    bool ReloadRequested;
+
+    FVXRConcurrentInsertQueue ConcurrentInserts;
+    FThreadSafeBool AcceptConcurrentInserts;
+
+    bool AnalysisInProgress;
 };
@@ -0,0 +1,29 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "VXRSpatialIndex.h"
+#include "UObject/WeakObjectPtr.h"
+
+// Spatial index over an AVXROctree actor tree. Nearest queries keep the octree semantics:
+// candidates come from the first leaf containing the query position.
+class XRCAMERACALIBRATION_API FVXROctreeSpatialIndex : public IVXRSpatialIndex
+{
+public:
+    explicit FVXROctreeSpatialIndex( class AVXROctree* InRootOctree );
+
+    virtual bool Insert( const FVXRCameraData& InCameraData ) override;
+    virtual bool Remove( const FVector& InPosition, float InTolerance ) override;
+
+    virtual int32 FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const override;
+    virtual void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const override;
+
+    virtual void GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const override;
+    virtual void GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const override;
+    virtual int32 Num() const override;
+
+    virtual const TCHAR* GetName() const override;
+
+    class AVXROctree* GetRootOctree() const;
+
+private:
+    TWeakObjectPtr<class AVXROctree> RootOctree;
+};
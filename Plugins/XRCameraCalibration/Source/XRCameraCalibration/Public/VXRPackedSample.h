@@ -0,0 +1,49 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "Math/Float16.h"
+#include "VXRCameraData.h"
+
+// Compact calibration sample: position quantized to 16 bits per axis relative to the owning leaf bounds,
+// yaw/pitch offsets stored as half floats. 10 bytes per sample, used both in memory and on disk.
+struct XRCAMERACALIBRATION_API FVXRPackedSample
+{
+    uint16 X;
+    uint16 Y;
+    uint16 Z;
+    FFloat16 OffsetYaw;
+    FFloat16 OffsetPitch;
+
+    FVXRPackedSample() = default;
+
+    static FVXRPackedSample Encode( const FVector& InPosition, float InOffsetYaw, float InOffsetPitch,
+        const FVector& InBoundsOrigin, const FVector& InBoundsExtent );
+
+    FVector DecodePosition( const FVector& InBoundsOrigin, const FVector& InBoundsExtent ) const;
+    FVXRCameraData Decode( const FVector& InBoundsOrigin, const FVector& InBoundsExtent ) const;
+
+    friend FArchive& operator<<( FArchive& Ar, FVXRPackedSample& InSample );
+};
+
+//-----------------------------------------------------------------------------
+
+// Block of packed samples sharing one set of quantization bounds. This is the unit written to
+// the binary element data file (.vxrc).
+struct XRCAMERACALIBRATION_API FVXRPackedSampleBlock
+{
+    FVector Origin;
+    FVector Extent;
+    TArray<FVXRPackedSample> Samples;
+
+    FVXRPackedSampleBlock() = default;
+
+    friend FArchive& operator<<( FArchive& Ar, FVXRPackedSampleBlock& InBlock );
+};
+
+//-----------------------------------------------------------------------------
+
+namespace VXRPackedSampleFile
+{
+    XRCAMERACALIBRATION_API bool Save( const FString& InFilePath, const TArray<FVXRPackedSampleBlock>& InBlocks );
+    XRCAMERACALIBRATION_API bool Load( const FString& InFilePath, TArray<FVXRPackedSampleBlock>& OutBlocks );
+}
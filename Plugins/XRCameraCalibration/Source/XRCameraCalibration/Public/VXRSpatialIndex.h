@@ -0,0 +1,63 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "VXRCameraData.h"
+#include "VXRPackedSample.h"
+#include "VXRSpatialIndex.generated.h"
+
+UENUM( BlueprintType )
+enum class EVXRSpatialIndexType : uint8
+{
+    Octree,
+    HashGrid,
+    VersionedOctree,
+    CompactOctree
+};
+
+//-----------------------------------------------------------------------------
+
+// Storage/query backend for calibration samples. Queries are const. FindNearest does not allocate
+// for InCount up to InlineNearestCount; larger counts spill the candidate list to the heap.
+class XRCAMERACALIBRATION_API IVXRSpatialIndex
+{
+public:
+    static const int32 InlineNearestCount = 8;
+
+    // (squared distance, value) candidates of a nearest search, closest first.
+    template<typename ValueType>
+    using TNearestList = TArray<TPair<float, ValueType>, TInlineAllocator<InlineNearestCount>>;
+
+    // Inserts a candidate in distance order and keeps the list at InCount entries.
+    template<typename ValueType>
+    static void AddNearestCandidate( TNearestList<ValueType>& InOutNearest, int32 InCount, float InDistSq, const ValueType& InValue )
+    {
+        if ( InOutNearest.Num() == InCount && InDistSq >= InOutNearest.Last().Key )
+            return;
+
+        int32 insertIdx = InOutNearest.Num();
+        while ( insertIdx > 0 && InOutNearest[insertIdx - 1].Key > InDistSq )
+            --insertIdx;
+
+        InOutNearest.Insert( TPair<float, ValueType>( InDistSq, InValue ), insertIdx );
+        if ( InOutNearest.Num() > InCount )
+            InOutNearest.Pop( false );
+    }
+
+public:
+    virtual ~IVXRSpatialIndex() = default;
+
+    virtual bool Insert( const FVXRCameraData& InCameraData ) = 0;
+    // Removes the sample closest to InPosition if it lies within InTolerance.
+    virtual bool Remove( const FVector& InPosition, float InTolerance ) = 0;
+
+    // Writes up to InCount nearest samples, closest first, and returns how many were written.
+    virtual int32 FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const = 0;
+    // Appends every sample inside InBox.
+    virtual void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const = 0;
+
+    virtual void GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const = 0;
+    virtual void GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const = 0;
+    virtual int32 Num() const = 0;
+
+    virtual const TCHAR* GetName() const = 0;
+};
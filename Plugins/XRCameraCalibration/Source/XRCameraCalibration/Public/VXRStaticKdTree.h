@@ -0,0 +1,53 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "VXRCameraData.h"
+
+struct FVXRKdNode
+{
+    float SplitValue;
+    // Split axis for inner nodes, INDEX_NONE for leaves.
+    int32 Axis;
+    // Sample range of the node inside the sample block.
+    int32 Begin;
+    int32 Count;
+};
+
+//-----------------------------------------------------------------------------
+
+// Immutable kd-tree over calibration samples. Nodes form a complete binary tree addressed implicitly
+// (children of i are 2i+1 and 2i+2) and samples are reordered so every leaf is a contiguous run in
+// traversal order. Nodes and samples live in one allocation.
+class XRCAMERACALIBRATION_API FVXRStaticKdTree
+{
+public:
+    void Build( const TArray<FVXRCameraData>& InCameraDatas );
+    // Adopts a previously built tree from its raw storage (see GetStorage). Fails if the size does not match the counts.
+    bool InitFromStorage( const void* InData, int64 InSize, int32 InNodeCount, int32 InSampleCount );
+    void Reset();
+
+    int32 FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const;
+    void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const;
+
+    bool IsEmpty() const;
+    int32 Num() const;
+    int32 GetNodeCount() const;
+    SIZE_T GetAllocatedSize() const;
+
+    const FVXRKdNode* GetNodes() const;
+    const FVXRCameraData* GetSamples() const;
+    const TArray<uint8>& GetStorage() const;
+
+public:
+    static const int32 LeafSize = 8;
+
+private:
+    FVXRKdNode* GetMutableNodes();
+    FVXRCameraData* GetMutableSamples();
+    void BuildNode( int32 InNodeIndex, int32 InBegin, int32 InEnd, int32 InLevel, int32 InLeafLevel );
+
+private:
+    TArray<uint8> Storage;
+    int32 NodeCount = 0;
+    int32 SampleCount = 0;
+};
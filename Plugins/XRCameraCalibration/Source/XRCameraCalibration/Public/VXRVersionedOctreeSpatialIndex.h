@@ -0,0 +1,72 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "VXRSpatialIndex.h"
+#include "Templates/SharedPointer.h"
+
+struct FVXRVersionedOctreeNode;
+
+// Persistent octree: nodes are immutable and shared between versions, and every edit copies only the
+// nodes on the path from the root to the modified leaf. A version is just a root pointer, so snapshots,
+// undo/redo and switching between named versions are O(1) and memory grows with the differences only.
+class XRCAMERACALIBRATION_API FVXRVersionedOctreeSpatialIndex : public IVXRSpatialIndex
+{
+public:
+    FVXRVersionedOctreeSpatialIndex( const FVector& InOrigin, const FVector& InExtent, int32 InLeafCapacity, int32 InMaxDepth,
+        int32 InMaxHistory = 64 );
+
+    virtual bool Insert( const FVXRCameraData& InCameraData ) override;
+    virtual bool Remove( const FVector& InPosition, float InTolerance ) override;
+
+    virtual int32 FindNearest( const FVector& InPosition, FVXRCameraData* OutCameraDatas, int32 InCount ) const override;
+    virtual void QueryBox( const FBox& InBox, TArray<FVXRCameraData>& OutCameraDatas ) const override;
+
+    virtual void GetCameraDatas( TArray<FVXRCameraData>& OutCameraDatas ) const override;
+    virtual void GetPackedSampleBlocks( TArray<FVXRPackedSampleBlock>& OutBlocks ) const override;
+    virtual int32 Num() const override;
+
+    virtual const TCHAR* GetName() const override;
+
+    // Undo/redo step over edits (insert, remove, version switch).
+    bool Undo();
+    bool Redo();
+    bool CanUndo() const;
+    bool CanRedo() const;
+
+    // Edits between Begin and End form a single undo step, e.g. a file load.
+    void BeginEditGroup();
+    void EndEditGroup();
+
+    void SaveVersion( FName InName );
+    bool SwitchVersion( FName InName );
+    bool RemoveVersion( FName InName );
+    void GetVersionNames( TArray<FName>& OutNames ) const;
+
+private:
+    typedef TSharedPtr<const FVXRVersionedOctreeNode> FNodePtr;
+
+    struct FVersion
+    {
+        FNodePtr Root;
+        int32 Count = 0;
+    };
+
+    FNodePtr InsertNode( const FNodePtr& InNode, const FVector& InCenter, const FVector& InExtent, int32 InDepth,
+        const FVXRCameraData& InCameraData ) const;
+    FNodePtr RemoveNode( const FNodePtr& InNode, const FVector& InCenter, const FVector& InExtent, const FVector& InPosition ) const;
+
+    void PushUndo();
+
+private:
+    FVector Origin;
+    FVector Extent;
+    int32 LeafCapacity;
+    int32 MaxDepth;
+    int32 MaxHistory;
+    int32 EditGroupDepth;
+    bool EditGroupPushed;
+
+    FVersion Current;
+    TArray<FVersion> UndoStack;
+    TArray<FVersion> RedoStack;
+    TMap<FName, FVersion> NamedVersions;
+};
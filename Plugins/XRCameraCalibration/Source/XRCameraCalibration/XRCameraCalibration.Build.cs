@@ -21,5 +21,16 @@ public class XRCameraCalibration : ModuleRules
 				"Engine", 
 				"InputCore"
 			});
+
+		// Hot reload of the element data file relies on the developer-only directory watcher.
+		if (Target.bBuildDeveloperTools)
+		{
+			PrivateDependencyModuleNames.Add("DirectoryWatcher");
+			PrivateDefinitions.Add("VXR_WITH_HOT_RELOAD=1");
+		}
+		else
+		{
+			PrivateDefinitions.Add("VXR_WITH_HOT_RELOAD=0");
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "VXRCalibrationDataAssetFactory.h"
+#include "VXRCalibrationDataAsset.h"
+#include "VXRCalibrationTextCodec.h"
+#include "VXRPackedSample.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+
+namespace
+{
+    const int64 HeaderProbeSize = 512;
+}
+
+//-----------------------------------------------------------------------------
+
+UVXRCalibrationDataAssetFactory::UVXRCalibrationDataAssetFactory( const FObjectInitializer& ObjectInitializer )
+    : Super( ObjectInitializer )
+{
+    SupportedClass = UVXRCalibrationDataAsset::StaticClass();
+    bCreateNew = false;
+    bEditorImport = true;
+    bText = false;
+
+    Formats.Add( TEXT( "txt;VXR Calibration Text" ) );
+    Formats.Add( TEXT( "vxrc;VXR Packed Calibration" ) );
+}
+
+bool UVXRCalibrationDataAssetFactory::FactoryCanImport( const FString& Filename )
+{
+    if ( FPaths::GetExtension( Filename ).Equals( TEXT( "vxrc" ), ESearchCase::IgnoreCase ) )
+        return true;
+
+    // .txt is shared with other importers, only claim files that start with a calibration line. The head of
+    // the file is enough for that, large calibrations are not read in full.
+    TUniquePtr<FArchive> reader( IFileManager::Get().CreateFileReader( *Filename ) );
+    if ( !reader.IsValid() )
+        return false;
+
+    TArray<uint8> head;
+    head.SetNumUninitialized( (int32)FMath::Min<int64>( reader->TotalSize(), HeaderProbeSize ) );
+    reader->Serialize( head.GetData(), head.Num() );
+    if ( !reader->Close() )
+        return false;
+
+    FString text;
+    FFileHelper::BufferToString( text, head.GetData(), head.Num() );
+    return text.TrimStart().StartsWith( FVXRCalibrationTextCodec::LinePrefix );
+}
+
+UObject* UVXRCalibrationDataAssetFactory::FactoryCreateFile( UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, 
+    const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled )
+{
+    TArray<FVXRCameraData> cameraDatas;
+    if ( FPaths::GetExtension( Filename ).Equals( TEXT( "vxrc" ), ESearchCase::IgnoreCase ) ) {
+        TArray<FVXRPackedSampleBlock> blocks;
+        if ( !VXRPackedSampleFile::Load( Filename, blocks ) ) {
+            Warn->Logf( ELogVerbosity::Error, TEXT( "Failed to read packed calibration file '%s'." ), *Filename );
+            return nullptr;
+        }
+
+        for ( auto& block : blocks ) {
+            for ( auto& sample : block.Samples )
+                cameraDatas.Add( sample.Decode( block.Origin, block.Extent ) );
+        }
+    }
+    else {
+        FVXRCalibrationTextCodec codec;
+        FVXRTextParseReport report;
+        if ( !codec.LoadFile( Filename, cameraDatas, report ) ) {
+            Warn->Logf( ELogVerbosity::Error, TEXT( "Failed to read calibration file '%s'." ), *Filename );
+            return nullptr;
+        }
+
+        if ( report.MalformedLineCount > 0 )
+            Warn->Logf( ELogVerbosity::Warning, TEXT( "Skipped %d malformed lines in '%s'." ), report.MalformedLineCount, *Filename );
+    }
+
+    auto asset = NewObject<UVXRCalibrationDataAsset>( InParent, InClass, InName, Flags );
+    asset->SetCameraDatas( cameraDatas );
+#if WITH_EDITORONLY_DATA
+    asset->SourceFilePath = Filename;
+#endif
+
+    return asset;
+}
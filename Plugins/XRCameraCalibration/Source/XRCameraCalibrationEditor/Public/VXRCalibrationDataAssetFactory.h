@@ -0,0 +1,15 @@
+// Copyright ViveStudios. All Rights Reserved.
+#pragma once
+#include "Factories/Factory.h"
+#include "VXRCalibrationDataAssetFactory.generated.h"
+
+// Imports calibration files (.txt legacy text, .vxrc packed) as UVXRCalibrationDataAsset with a prebuilt index.
+UCLASS()
+class XRCAMERACALIBRATIONEDITOR_API UVXRCalibrationDataAssetFactory : public UFactory
+{
+    GENERATED_UCLASS_BODY()
+public:
+    virtual UObject* FactoryCreateFile( UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, 
+        const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled ) override;
+    virtual bool FactoryCanImport( const FString& Filename ) override;
+};
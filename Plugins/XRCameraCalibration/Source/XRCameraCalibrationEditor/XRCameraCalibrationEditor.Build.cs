@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class XRCameraCalibrationEditor : ModuleRules
+{
+	public XRCameraCalibrationEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		bEnforceIWYU = false;
+		
+		PrivateIncludePaths.AddRange(
+		    new string[] {
+				"XRCameraCalibrationEditor/Private"
+			});
+
+		PrivateDependencyModuleNames.AddRange(
+		    new string[] {
+				"Core", 
+				"CoreUObject", 
+				"Engine", 
+				"UnrealEd",
+				"XRCameraCalibration"
+			});
+	}
+}